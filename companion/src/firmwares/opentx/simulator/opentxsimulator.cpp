@@ -256,6 +256,7 @@ namespace NAMESPACE {
 #include "radio/src/translations.cpp"
 #include "radio/src/telemetry/frsky.cpp"
 #include "radio/src/telemetry/frsky_d.cpp"
+#include "radio/src/targets/simu/telemetry_replay.cpp"
 #include "radio/src/translations/tts_en.cpp"
 
 #if defined(CPUARM)
@@ -348,6 +349,9 @@ void OpenTxSimulator::setSdPath(const QString &sdPath)
 
 bool OpenTxSimulator::timer10ms()
 {
+#if defined(CPUARM) && defined(FRSKY)
+  telemetryReplayTick();
+#endif
 #define TIMER10MS_IMPORT
 #include "simulatorimport.h"
 }
@@ -481,6 +485,18 @@ void OpenTxSimulator::sendTelemetry(::uint8_t * data, unsigned int len)
 #endif
 }
 
+bool OpenTxSimulator::replayTelemetry(const char * filename, unsigned int speed)
+{
+#if defined(CPUARM) && defined(FRSKY)
+  if (!telemetryReplayLoad(filename))
+    return false;
+  telemetryReplayStart(speed);
+  return true;
+#else
+  return false;
+#endif
+}
+
 void OpenTxSimulator::setTrainerInput(unsigned int inputNumber, ::int16_t value)
 {
 #define SETTRAINER_IMPORT
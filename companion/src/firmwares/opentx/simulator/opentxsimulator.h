@@ -113,6 +113,8 @@ class DLLEXPORT OpenTxSimulator : public SimulatorInterface {
 
     virtual void sendTelemetry(uint8_t * data, unsigned int len);
 
+    virtual bool replayTelemetry(const char * filename, unsigned int speed);
+
     virtual void setTrainerInput(unsigned int inputNumber, int16_t value);
 
     virtual void installTraceHook(void (*callback)(const char *));
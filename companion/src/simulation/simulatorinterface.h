@@ -97,6 +97,9 @@ class SimulatorInterface
 
     virtual void sendTelemetry(uint8_t * data, unsigned int len) = 0;
 
+    // replays a sport.log recorded by the radio, speed times faster than the recording
+    virtual bool replayTelemetry(const char * filename, unsigned int speed) { return false; }
+
     virtual void setTrainerInput(unsigned int inputNumber, int16_t value) = 0;
 
     virtual void installTraceHook(void (*callback)(const char *)) = 0;
@@ -1,4 +1,6 @@
 #include <stdint.h>
+#include <QFileDialog>
+#include <QMessageBox>
 #include "telemetrysimu.h"
 #include "ui_telemetrysimu.h"
 #include "simulatorinterface.h"
@@ -29,6 +31,17 @@ void TelemetrySimulator::onTimerEvent()
   }
 }
 
+void TelemetrySimulator::on_Replay_clicked()
+{
+  QString fileName = QFileDialog::getOpenFileName(this, tr("Select a telemetry log"), QString(), tr("Telemetry logs (*.log)"));
+  if (!fileName.isEmpty()) {
+    ui->Simulate->setChecked(false);
+    if (!simulator->replayTelemetry(fileName.toLocal8Bit().constData(), 1)) {
+      QMessageBox::warning(this, tr("Telemetry Simulator"), tr("No telemetry found in %1").arg(fileName));
+    }
+  }
+}
+
 void TelemetrySimulator::closeEvent(QCloseEvent *event)
 {
   ui->Simulate->setChecked(false);
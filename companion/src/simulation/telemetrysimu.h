@@ -33,6 +33,7 @@ class TelemetrySimulator : public QDialog
 
   private slots:
     void onTimerEvent();
+    void on_Replay_clicked();
 
 };
 
@@ -36,6 +36,7 @@
 
 #include "opentx.h"
 #include <math.h>
+#include <ctype.h>
 
 extern OS_MutexID audioMutex;
 
@@ -237,9 +238,66 @@ void getSystemAudioFile(char * filename, int index)
   strcat(str, SOUNDS_EXT);
 }
 
-void referenceSystemAudioFiles()
+AudioCatalog soundsAudioCatalog;
+AudioCatalog systemAudioCatalog;
+AudioCatalog modelAudioCatalog;
+
+uint32_t getAudioFileHash(const char * name)
+{
+  uint32_t hash = 2166136261u; // FNV-1a
+  for (const char * c=name; *c; c++) {
+    hash = (hash ^ (uint8_t)tolower(*c)) * 16777619u;
+  }
+  return hash ? hash : 1;
+}
+
+void AudioCatalog::add(const char * name)
+{
+  if (count >= AUDIO_CATALOG_SLOTS*3/4) {
+    complete = false;
+    return;
+  }
+
+  uint32_t hash = getAudioFileHash(name);
+  for (uint32_t i=hash; ; i++) {
+    uint32_t & slot = hashes[i & (AUDIO_CATALOG_SLOTS-1)];
+    if (slot == hash) {
+      return;
+    }
+    else if (slot == 0) {
+      slot = hash;
+      count++;
+      return;
+    }
+  }
+}
+
+bool AudioCatalog::contains(const char * name) const
+{
+  if (!complete) {
+    // the directory couldn't be scanned entirely, the file is looked for on the SD card
+    char filename[sizeof(path)+AUDIO_FILENAME_MAXLEN+1]; // the directory, '/' and the name
+    FIL file;
+    snprintf(filename, sizeof(filename), "%s/%s", path, name);
+    if (f_open(&file, filename, FA_OPEN_EXISTING | FA_READ) != FR_OK) {
+      return false;
+    }
+    f_close(&file);
+    return true;
+  }
+
+  uint32_t hash = getAudioFileHash(name);
+  for (uint32_t i=hash; ; i++) {
+    uint32_t slot = hashes[i & (AUDIO_CATALOG_SLOTS-1)];
+    if (slot == hash)
+      return true;
+    else if (slot == 0)
+      return false;
+  }
+}
+
+void AudioCatalog::load(const char * directory)
 {
-  char path[AUDIO_FILENAME_MAXLEN+1];
   FILINFO fno;
   DIR dir;
   char *fn;   /* This function is assuming non-Unicode cfg. */
@@ -247,37 +305,82 @@ void referenceSystemAudioFiles()
   fno.lfname = lfn;
   fno.lfsize = sizeof(lfn);
 
-  uint64_t availableAudioFiles = 0;
-
-  assert(sizeof(audioFilenames)==AU_FRSKY_FIRST*sizeof(char *));
-  assert(sizeof(sdAvailableSystemAudioFiles)*8 >= AU_FRSKY_FIRST);
-
-  char * filename = getSystemAudioPath(path);
-  *(filename-1) = '\0';
+  clear();
+  strncpy(path, directory, AUDIO_FILENAME_MAXLEN);
 
-  FRESULT res = f_opendir(&dir, path);        /* Open the directory */
+  FRESULT res = f_opendir(&dir, directory);        /* Open the directory */
   if (res == FR_OK) {
+    complete = true;
     for (;;) {
       res = f_readdir(&dir, &fno);                   /* Read a directory item */
-      if (res != FR_OK || fno.fname[0] == 0) break;  /* Break on error or end of dir */
+      if (res != FR_OK) {
+        complete = false;
+        break;
+      }
+      if (fno.fname[0] == 0) break;                  /* Break on end of dir */
       fn = *fno.lfname ? fno.lfname : fno.fname;
       uint8_t len = strlen(fn);
 
       // Eliminates directories / non wav files
       if (len < 5 || strcasecmp(fn+len-4, SOUNDS_EXT) || (fno.fattrib & AM_DIR)) continue;
 
-      for (int i=0; i<AU_FRSKY_FIRST; i++) {
-        getSystemAudioFile(path, i);
-        if (!strcasecmp(filename, fn)) {
-          availableAudioFiles |= MASK_SYSTEM_AUDIO_FILE(i);
-          break;
-        }
-      }
+      add(fn);
     }
     f_closedir(&dir);
   }
 
+  TRACE("AudioCatalog::load(%s): %d files%s", directory, count, complete ? "" : ", incomplete");
+}
+
+// Files in the directories which are not in a catalog are always considered available
+bool isAudioFileAvailable(const char * filename)
+{
+  const char * name = strrchr(filename, '/');
+  if (!name) {
+    return true;
+  }
+
+  unsigned int len = name - filename;
+  const AudioCatalog * catalogs[] = { &soundsAudioCatalog, &systemAudioCatalog, &modelAudioCatalog };
+  for (unsigned int i=0; i<DIM(catalogs); i++) {
+    const AudioCatalog * catalog = catalogs[i];
+    if (strlen(catalog->path) == len && !strncasecmp(catalog->path, filename, len)) {
+      return catalog->contains(name+1);
+    }
+  }
+
+  return true;
+}
+
+void referenceSystemAudioFiles()
+{
+  char path[AUDIO_FILENAME_MAXLEN+1];
+  uint64_t availableAudioFiles = 0;
+
+  assert(sizeof(audioFilenames)==AU_FRSKY_FIRST*sizeof(char *));
+  assert(sizeof(sdAvailableSystemAudioFiles)*8 >= AU_FRSKY_FIRST);
+
+  char * filename = getAudioPath(path);
+  *(filename-1) = '\0';
+  soundsAudioCatalog.load(path);
+
+  filename = getSystemAudioPath(path);
+  *(filename-1) = '\0';
+  systemAudioCatalog.load(path);
+
+  for (int i=0; i<AU_FRSKY_FIRST; i++) {
+    getSystemAudioFile(path, i);
+    if (systemAudioCatalog.contains(filename)) {
+      availableAudioFiles |= MASK_SYSTEM_AUDIO_FILE(i);
+    }
+  }
+
   sdAvailableSystemAudioFiles = availableAudioFiles;
+
+#if defined(AUDIO_CACHE_SIZE)
+  // the SD card content may have changed, the audio task reloads the cache
+  audioCache.prefillRequested = true;
+#endif
 }
 
 const char * const suffixes[] = { "-off", "-on" };
@@ -337,73 +440,44 @@ void getLogicalSwitchAudioFile(char * filename, int index, unsigned int event)
 void referenceModelAudioFiles()
 {
   char path[AUDIO_FILENAME_MAXLEN+1];
-  FILINFO fno;
-  DIR dir;
-  char *fn;   /* This function is assuming non-Unicode cfg. */
-  TCHAR lfn[_MAX_LFN + 1];
-  fno.lfname = lfn;
-  fno.lfsize = sizeof(lfn);
 
   sdAvailablePhaseAudioFiles = 0;
   sdAvailableSwitchAudioFiles = 0;
   sdAvailableLogicalSwitchAudioFiles = 0;
-  
+
   char * filename = getModelAudioPath(path);
   *(filename-1) = '\0';
-
-  FRESULT res = f_opendir(&dir, path);        /* Open the directory */
-  if (res == FR_OK) {
-    for (;;) {
-      res = f_readdir(&dir, &fno);                   /* Read a directory item */
-      if (res != FR_OK || fno.fname[0] == 0) break;  /* Break on error or end of dir */
-      fn = *fno.lfname ? fno.lfname : fno.fname;
-      uint8_t len = strlen(fn);
-      bool found = false;
-
-      // Eliminates directories / non wav files
-      if (len < 5 || strcasecmp(fn+len-4, SOUNDS_EXT) || (fno.fattrib & AM_DIR)) continue;
-      TRACE("referenceModelAudioFiles(): using file: %s", fn);
-
-      // Phases Audio Files <phasename>-[on|off].wav
-      for (int i=0; i<MAX_FLIGHT_MODES && !found; i++) {
-        for (int event=0; event<2; event++) {
-          getPhaseAudioFile(path, i, event);
-          // TRACE("referenceModelAudioFiles(): searching for %s in %s", filename, fn);
-          if (!strcasecmp(filename, fn)) {
-            sdAvailablePhaseAudioFiles |= MASK_PHASE_AUDIO_FILE(i, event);
-            found = true;
-            TRACE("\tfound: %s", filename);
-            break;
-          }
-        }
+  modelAudioCatalog.load(path);
+
+  // Phases Audio Files <phasename>-[on|off].wav
+  for (int i=0; i<MAX_FLIGHT_MODES; i++) {
+    for (int event=0; event<2; event++) {
+      getPhaseAudioFile(path, i, event);
+      if (modelAudioCatalog.contains(filename)) {
+        sdAvailablePhaseAudioFiles |= MASK_PHASE_AUDIO_FILE(i, event);
+        TRACE("\tfound: %s", filename);
       }
+    }
+  }
 
-      // Switches Audio Files <switchname>-[up|mid|down].wav
-      for (int i=0; i<SWSRC_LAST_SWITCH+NUM_XPOTS*XPOTS_MULTIPOS_COUNT && !found; i++) {
-        getSwitchAudioFile(path, i);
-        // TRACE("referenceModelAudioFiles(): searching for %s in %s", filename, fn);
-        if (!strcasecmp(filename, fn)) {
-          sdAvailableSwitchAudioFiles |= MASK_SWITCH_AUDIO_FILE(i);
-          found = true;
-          TRACE("\tfound: %s", filename);
-        }
-      }
+  // Switches Audio Files <switchname>-[up|mid|down].wav
+  for (int i=0; i<SWSRC_LAST_SWITCH+NUM_XPOTS*XPOTS_MULTIPOS_COUNT; i++) {
+    getSwitchAudioFile(path, i);
+    if (modelAudioCatalog.contains(filename)) {
+      sdAvailableSwitchAudioFiles |= MASK_SWITCH_AUDIO_FILE(i);
+      TRACE("\tfound: %s", filename);
+    }
+  }
 
-      // Logical Switches Audio Files <switchname>-[on|off].wav
-      for (int i=0; i<NUM_LOGICAL_SWITCH && !found; i++) {
-        for (int event=0; event<2; event++) {
-          getLogicalSwitchAudioFile(path, i, event);
-          // TRACE("referenceModelAudioFiles(): searching for %s in %s", filename, fn);
-          if (!strcasecmp(filename, fn)) {
-            sdAvailableLogicalSwitchAudioFiles |= MASK_LOGICAL_SWITCH_AUDIO_FILE(i, event);
-            found = true;
-            TRACE("\tfound: %s", filename);
-            break;
-          }
-        }
+  // Logical Switches Audio Files <switchname>-[on|off].wav
+  for (int i=0; i<NUM_LOGICAL_SWITCH; i++) {
+    for (int event=0; event<2; event++) {
+      getLogicalSwitchAudioFile(path, i, event);
+      if (modelAudioCatalog.contains(filename)) {
+        sdAvailableLogicalSwitchAudioFiles |= MASK_LOGICAL_SWITCH_AUDIO_FILE(i, event);
+        TRACE("\tfound: %s", filename);
       }
     }
-    f_closedir(&dir);
   }
 }
 
@@ -469,6 +543,7 @@ AudioQueue audioQueue;
 AudioQueue::AudioQueue()
 {
   memset(this, 0, sizeof(AudioQueue));
+  ducking = AUDIO_GAIN_UNITY;
 }
 
 void AudioQueue::start()
@@ -504,128 +579,389 @@ void audioTask(void* pdata)
 }
 #endif
 
-void mixSample(uint16_t * result, int sample, unsigned int fade)
+void AudioMixBuffer::convert(AudioBuffer * buffer, int size) const
 {
+  for (int i=0; i<size; i++) {
 #if defined(SIMU_AUDIO)
-  *result = limit(0, *result + ((sample >> fade) ), 0xFFFF);
+    buffer->data[i] = limit<int32_t>(0, 0x8000 + data[i], 0xFFFF);
 #else
-  *result = limit(0, *result + ((sample >> fade) >> 4), 4095);
+    buffer->data[i] = limit<int32_t>(0, (0x8000 >> 4) + (data[i] >> 4), 4095);
 #endif
+  }
 }
 
 #if defined(SDCARD)
 
-#define RIFF_CHUNK_SIZE 12
-uint8_t wavBuffer[AUDIO_BUFFER_SIZE*2];
+#define RIFF_CHUNK_SIZE     12
+#define WAV_FMT_CHUNK_MAX   256                     // the fmt chunk is read at once with the header of the next chunk
+#define WAV_HEADER_MAX_SIZE (WAV_FMT_CHUNK_MAX+8)
 
-int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+uint16_t wavUnderruns = 0;
+
+FRESULT readWavHeader(FIL * file, uint8_t * header, uint8_t & codec, uint32_t & freq, uint32_t & dataSize)
 {
-  FRESULT result = FR_OK;
+  // the header is read in the data of a WAV context or of a cache slot, checked at compile time as
+  // static_assert() would do, the firmware is built in C++98
+  struct WavHeaderFits {
+    char context[WAV_BUFFER_SIZE >= WAV_HEADER_MAX_SIZE ? 1 : -1];
+#if defined(AUDIO_CACHE_SIZE)
+    char cache[AUDIO_CACHE_SLOT_SIZE >= WAV_HEADER_MAX_SIZE ? 1 : -1];
+#endif
+  };
+
   UINT read = 0;
 
-  if (fragment.file[1]) {
-    result = f_open(&state.file, fragment.file, FA_OPEN_EXISTING | FA_READ);
-    fragment.file[1] = 0;
-    if (result == FR_OK) {
-      result = f_read(&state.file, wavBuffer, RIFF_CHUNK_SIZE+8, &read);
-      if (result == FR_OK && read == RIFF_CHUNK_SIZE+8 && !memcmp(wavBuffer, "RIFF", 4) && !memcmp(wavBuffer+8, "WAVEfmt ", 8)) {
-        uint32_t size = *((uint32_t *)(wavBuffer+16));
-        result = (size < 256 ? f_read(&state.file, wavBuffer, size+8, &read) : FR_DENIED);
-        if (result == FR_OK && read == size+8) {
-          state.codec = ((uint16_t *)wavBuffer)[0];
-          state.freq = ((uint16_t *)wavBuffer)[2];
-          uint32_t *wavSamplesPtr = (uint32_t *)(wavBuffer + size);
-          uint32_t size = wavSamplesPtr[1];
-          if (state.freq != 0 && state.freq * (AUDIO_SAMPLE_RATE / state.freq) == AUDIO_SAMPLE_RATE) {
-            state.resampleRatio = (AUDIO_SAMPLE_RATE / state.freq);
-            state.readSize = (state.codec == CODEC_ID_PCM_S16LE ? 2*AUDIO_BUFFER_SIZE : AUDIO_BUFFER_SIZE) / state.resampleRatio;
-          }
-          else {
-            result = FR_DENIED;
-          }
-          while (result == FR_OK && memcmp(wavSamplesPtr, "data", 4) != 0) {
-            result = f_lseek(&state.file, f_tell(&state.file)+size);
-            if (result == FR_OK) {
-              result = f_read(&state.file, wavBuffer, 8, &read);
-              if (read != 8) result = FR_DENIED;
-              wavSamplesPtr = (uint32_t *)wavBuffer;
-              size = wavSamplesPtr[1];
-            }
-          }
-          state.size = size;
-        }
-        else {
-          result = FR_DENIED;
-        }
-      }
-      else {
+  FRESULT result = f_read(file, header, RIFF_CHUNK_SIZE+8, &read);
+  if (result == FR_OK && read == RIFF_CHUNK_SIZE+8 && !memcmp(header, "RIFF", 4) && !memcmp(header+8, "WAVEfmt ", 8)) {
+    uint32_t size = *((uint32_t *)(header+16));
+    result = (size < WAV_FMT_CHUNK_MAX ? f_read(file, header, size+8, &read) : FR_DENIED);
+    if (result == FR_OK && read == size+8) {
+      codec = ((uint16_t *)header)[0];
+      freq = ((uint32_t *)header)[1];
+      uint32_t *wavSamplesPtr = (uint32_t *)(header + size);
+      uint32_t size = wavSamplesPtr[1];
+      if (freq == 0 || freq > 48000 || (codec != CODEC_ID_PCM_S16LE && codec != CODEC_ID_PCM_ALAW && codec != CODEC_ID_PCM_MULAW)) {
         result = FR_DENIED;
       }
+      while (result == FR_OK && memcmp(wavSamplesPtr, "data", 4) != 0) {
+        result = f_lseek(file, f_tell(file)+size);
+        if (result == FR_OK) {
+          result = f_read(file, header, 8, &read);
+          if (read != 8) result = FR_DENIED;
+          wavSamplesPtr = (uint32_t *)header;
+          size = wavSamplesPtr[1];
+        }
+      }
+      dataSize = size;
+    }
+    else {
+      result = FR_DENIED;
     }
   }
+  else {
+    result = FR_DENIED;
+  }
 
-  read = 0;
-  if (result == FR_OK) {
-    result = f_read(&state.file, wavBuffer, state.readSize, &read);
-    if (result == FR_OK) {
-      if (read > state.size) {
-        read = state.size;
+  return result;
+}
+
+#if defined(AUDIO_CACHE_SIZE)
+AudioCache audioCache;
+
+void AudioCache::clear()
+{
+  for (unsigned int i=0; i<AUDIO_CACHE_SLOTS; i++) {
+    AudioCacheEntry & entry = entries[i];
+    if (!audioQueue.isCacheEntryPlayed(&entry)) {
+      entry.size = 0;
+    }
+  }
+}
+
+const AudioCacheEntry * AudioCache::find(const char * file)
+{
+  for (unsigned int i=0; i<AUDIO_CACHE_SLOTS; i++) {
+    AudioCacheEntry & entry = entries[i];
+    if (entry.size > 0 && !strcmp(entry.file, file)) {
+      entry.lastUse = ++useCounter;
+      hits++;
+      return &entry;
+    }
+  }
+  misses++;
+  return NULL;
+}
+
+// Returns the free entry or the least recently used one, the entries being played are never evicted
+AudioCacheEntry * AudioCache::allocate(const char * file)
+{
+  AudioCacheEntry * result = NULL;
+  for (unsigned int i=0; i<AUDIO_CACHE_SLOTS; i++) {
+    AudioCacheEntry * entry = &entries[i];
+    if (entry->size == 0) {
+      result = entry;
+      break;
+    }
+    else if ((!result || entry->lastUse < result->lastUse) && !audioQueue.isCacheEntryPlayed(entry)) {
+      result = entry;
+    }
+  }
+
+  if (result) {
+    result->size = 0;
+    strncpy(result->file, file, AUDIO_FILENAME_MAXLEN);
+    result->file[AUDIO_FILENAME_MAXLEN] = '\0';
+    result->lastUse = ++useCounter;
+  }
+
+  return result;
+}
+
+// Loads the number prompts of the language pack in the free entries, nothing is evicted
+void AudioCache::prefill()
+{
+  static FIL file; // not on the audio task stack
+  char filename[AUDIO_FILENAME_MAXLEN+1];
+  char * str = getSystemAudioPath(filename);
+
+  prefillRequested = false;
+  clear();
+
+  for (int prompt=0; prompt<100; prompt++) {
+    AudioCacheEntry * entry = NULL;
+    for (unsigned int i=0; i<AUDIO_CACHE_SLOTS; i++) {
+      if (entries[i].size == 0) {
+        entry = &entries[i];
+        break;
       }
-      state.size -= read;
+    }
+    if (!entry) {
+      break;
+    }
 
-      if (read != state.readSize) {
-        f_close(&state.file);
-        fragment.clear();
+    strcpy(str, "0000" SOUNDS_EXT);
+    for (int8_t i=3, value=prompt; i>=0; i--) {
+      str[i] = '0' + (value%10);
+      value /= 10;
+    }
+    if (!systemAudioCatalog.contains(str) || find(filename)) {
+      continue;
+    }
+
+    if (f_open(&file, filename, FA_OPEN_EXISTING | FA_READ) == FR_OK) {
+      uint32_t size;
+      UINT read = 0;
+      if (readWavHeader(&file, entry->data, entry->codec, entry->freq, size) == FR_OK && size > 0 && size <= AUDIO_CACHE_SLOT_SIZE &&
+          f_read(&file, entry->data, size, &read) == FR_OK && read == size) {
+        strcpy(entry->file, filename);
+        entry->lastUse = 0;
+        entry->size = size;
       }
+      f_close(&file);
+    }
+  }
 
-      uint16_t * samples = buffer->data;
-      if (state.codec == CODEC_ID_PCM_S16LE) {
-        read /= 2;
-        for (uint32_t i=0; i<read; i++) {
-          for (uint8_t j=0; j<state.resampleRatio; j++) {
-            mixSample(samples++, ((int16_t *)wavBuffer)[i], fade+2-volume);
-          }
-        }
+  hits = misses = 0;
+}
+#endif
+
+FRESULT WavContext::open()
+{
+#if defined(AUDIO_CACHE_SIZE)
+  state.cached = audioCache.find(fragment.file);
+  if (state.cached) {
+    state.codec = state.cached->codec;
+    state.freq = state.cached->freq;
+    state.size = state.cached->size;
+    state.step = (state.freq << WAV_STEP_SHIFT) / AUDIO_SAMPLE_RATE;
+    state.position = 2 << WAV_STEP_SHIFT;
+    state.samples[0] = state.samples[1] = 0;
+    state.readPos = state.writePos = 0;
+    return readAhead();
+  }
+#endif
+
+  FRESULT result = f_open(&state.file, fragment.file, FA_OPEN_EXISTING | FA_READ);
+  if (result != FR_OK) {
+    state.codec = 0;
+    return result;
+  }
+
+  result = readWavHeader(&state.file, state.data, state.codec, state.freq, state.size);
+
+  if (result == FR_OK) {
+    state.step = (state.freq << WAV_STEP_SHIFT) / AUDIO_SAMPLE_RATE;
+    state.position = 2 << WAV_STEP_SHIFT; // the first 2 samples are read before the first output
+    state.samples[0] = state.samples[1] = 0;
+    // data[] is aligned like the file, FatFs copies the whole sectors straight into it
+    state.readPos = state.writePos = f_tell(&state.file) & (WAV_READ_ALIGN-1);
+#if defined(AUDIO_CACHE_SIZE)
+    // a small prompt is read at once in the cache, it will be played from there next time
+    AudioCacheEntry * entry = (state.size > 0 && state.size <= AUDIO_CACHE_SLOT_SIZE ? audioCache.allocate(fragment.file) : NULL);
+    if (entry) {
+      UINT read = 0;
+      result = f_read(&state.file, entry->data, state.size, &read);
+      if (result == FR_OK) {
+        entry->codec = state.codec;
+        entry->freq = state.freq;
+        entry->size = state.size = read;
+        f_close(&state.file);
+        state.cached = entry;
+        state.readPos = state.writePos = 0;
       }
-      else if (state.codec == CODEC_ID_PCM_ALAW) {
-        for (uint32_t i=0; i<read; i++) {
-          for (uint8_t j=0; j<state.resampleRatio; j++) {
-            mixSample(samples++, alawTable[wavBuffer[i]], fade+2-volume);
-          }
+    }
+#endif
+    result = readAhead();
+  }
+
+  if (result != FR_OK) {
+    close();
+  }
+
+  return result;
+}
+
+void WavContext::close()
+{
+#if defined(AUDIO_CACHE_SIZE)
+  if (!state.cached)
+#endif
+  f_close(&state.file);
+  state.codec = 0;
+}
+
+FRESULT WavContext::readAhead()
+{
+#if defined(AUDIO_CACHE_SIZE)
+  if (state.cached) {
+    while (state.size > 0) {
+      uint32_t pos = state.writePos & (WAV_BUFFER_SIZE-1);
+      uint32_t count = min<uint32_t>(WAV_BUFFER_SIZE - pos, WAV_BUFFER_SIZE - (state.writePos - state.readPos));
+      if (count > state.size)
+        count = state.size;
+      if (count == 0)
+        break;
+      memcpy(&state.data[pos], &state.cached->data[state.cached->size - state.size], count);
+      state.writePos += count;
+      state.size -= count;
+    }
+    return FR_OK;
+  }
+#endif
+
+  // the whole free space is filled: as data[] is aligned like the file, FatFs reads the whole sectors
+  // straight into it and the others through the sector buffer of the file, each sector is read once
+  while (state.size > 0) {
+    uint32_t pos = state.writePos & (WAV_BUFFER_SIZE-1);
+    uint32_t count = min<uint32_t>(WAV_BUFFER_SIZE - pos, WAV_BUFFER_SIZE - (state.writePos - state.readPos));
+    if (count > state.size)
+      count = state.size;
+    if (count == 0)
+      break;
+
+    UINT read = 0;
+    FRESULT result = f_read(&state.file, &state.data[pos], count, &read);
+    if (result != FR_OK)
+      return result;
+    state.writePos += read;
+    state.size -= read;
+    if (read != count)
+      state.size = 0; // the file is truncated
+  }
+
+  return FR_OK;
+}
+
+bool WavContext::readSample(int16_t & sample)
+{
+  uint32_t available = state.writePos - state.readPos;
+
+  if (state.codec == CODEC_ID_PCM_S16LE) {
+    if (available < 2)
+      return false;
+    uint8_t low = state.data[state.readPos++ & (WAV_BUFFER_SIZE-1)];
+    uint8_t high = state.data[state.readPos++ & (WAV_BUFFER_SIZE-1)];
+    sample = (int16_t)(low | (high << 8));
+  }
+  else {
+    if (available < 1)
+      return false;
+    uint8_t value = state.data[state.readPos++ & (WAV_BUFFER_SIZE-1)];
+    sample = (state.codec == CODEC_ID_PCM_ALAW ? alawTable[value] : ulawTable[value]);
+  }
+
+  return true;
+}
+
+int WavContext::mixBuffer(AudioMixBuffer *buffer, int32_t gain)
+{
+  FRESULT result = FR_OK;
+
+  if (fragment.file[1]) {
+    result = open();
+    fragment.file[1] = 0;
+    if (result != FR_OK) {
+      return -result;
+    }
+  }
+  else if (state.codec == 0) {
+    return -FR_DENIED;
+  }
+  else if (state.writePos - state.readPos <= WAV_BUFFER_SIZE/2) {
+    result = readAhead();
+    if (result != FR_OK) {
+      close();
+      return -result;
+    }
+  }
+
+  // linear interpolation between the input samples
+  int i = 0;
+  for (; i<AUDIO_BUFFER_SIZE; i++) {
+    while (state.position >= (1 << WAV_STEP_SHIFT)) {
+      state.samples[0] = state.samples[1];
+      if (!readSample(state.samples[1])) {
+        if (state.size > 0) {
+          // the read-ahead is late, the end of the buffer is silent
+          wavUnderruns++;
+          TRACE("WAV underrun");
+          return AUDIO_BUFFER_SIZE;
         }
-      }
-      else if (state.codec == CODEC_ID_PCM_MULAW) {
-        for (uint32_t i=0; i<read; i++) {
-          for (uint8_t j=0; j<state.resampleRatio; j++) {
-            mixSample(samples++, ulawTable[wavBuffer[i]], fade+2-volume);
-          }
+        else {
+          close();
+          fragment.clear();
+          return i;
         }
       }
-
-      return samples - buffer->data;
+      state.position -= (1 << WAV_STEP_SHIFT);
     }
+    int32_t sample = state.samples[0] + (((state.samples[1] - state.samples[0]) * (int32_t)(state.position >> 1)) >> (WAV_STEP_SHIFT-1));
+    buffer->data[i] += (sample * gain) >> AUDIO_GAIN_SHIFT;
+    state.position += state.step;
   }
 
-  return -result;
+  return i;
 }
 #else
-int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+int WavContext::mixBuffer(AudioMixBuffer *buffer, int32_t gain)
 {
   return 0;
 }
 #endif
 
 const unsigned int toneVolumes[] = { 10, 8, 6, 4, 2 };
-inline float evalVolumeRatio(int freq, int volume)
+
+int32_t getToneVolumeGain(int volume)
 {
-  float result = toneVolumes[2+volume];
-  if (freq < 330) {
-    result = (result * freq * freq) / (330 * 330);
+  return AUDIO_GAIN_UNITY / toneVolumes[2+volume];
+}
+
+int32_t getWavVolumeGain(int volume)
+{
+  return AUDIO_GAIN_UNITY >> (2-volume);
+}
+
+// The tones are produced with a 32bit phase accumulator: its 10 upper bits are the index in the
+// sineValues table, the next 8 bits interpolate between 2 values of the table
+#define TONE_PHASE_INDEX_SHIFT  22
+#define TONE_PHASE_FRAC_SHIFT   (TONE_PHASE_INDEX_SHIFT-8)
+#define TONE_GAIN_MAX           (32 * AUDIO_GAIN_UNITY)
+
+inline int32_t evalToneGain(int freq)
+{
+  // the low frequencies are played louder
+  if (freq >= 330) {
+    return AUDIO_GAIN_UNITY;
+  }
+  else if (freq == 0) {
+    return 0;
+  }
+  else {
+    return (uint32_t(AUDIO_GAIN_UNITY) * 330 * 330) / (freq * freq);
   }
-  return result;
 }
 
-int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
+int ToneContext::mixBuffer(AudioMixBuffer *buffer, int32_t gain)
 {
   int duration = 0;
   int result = 0;
@@ -633,7 +969,7 @@ int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
   int remainingDuration = fragment.tone.duration - state.duration;
   if (remainingDuration > 0) {
     int points;
-    double toneIdx = state.idx;
+    uint32_t phase = state.phase;
 
     if (fragment.tone.reset) {
       fragment.tone.reset = 0;
@@ -643,8 +979,8 @@ int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
 
     if (fragment.tone.freq != state.freq) {
       state.freq = fragment.tone.freq;
-      state.step = double(DIM(sineValues)*fragment.tone.freq) / AUDIO_SAMPLE_RATE;
-      state.volume = evalVolumeRatio(fragment.tone.freq, volume);
+      state.step = (uint64_t(fragment.tone.freq) << 32) / AUDIO_SAMPLE_RATE;
+      state.gain = evalToneGain(fragment.tone.freq);
     }
 
     if (fragment.tone.freqIncr) {
@@ -658,25 +994,29 @@ int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
     else {
       duration = remainingDuration;
       points = (duration * AUDIO_BUFFER_SIZE) / AUDIO_BUFFER_DURATION;
-      unsigned int end = toneIdx + (state.step * points);
-      if (end > DIM(sineValues))
-        end -= (end % DIM(sineValues));
-      else
-        end = DIM(sineValues);
-      points = (double(end) - toneIdx) / state.step;
+      if (state.step) {
+        // the tone is stopped at the end of a period
+        uint64_t end = phase + uint64_t(state.step) * points;
+        if (end > (uint64_t(1) << 32))
+          end &= ~uint64_t(0xFFFFFFFF);
+        else
+          end = (uint64_t(1) << 32);
+        points = min<uint64_t>((end - phase) / state.step, AUDIO_BUFFER_SIZE);
+      }
     }
 
+    gain = min<int64_t>((int64_t(state.gain) * gain) >> AUDIO_GAIN_SHIFT, TONE_GAIN_MAX);
     for (int i=0; i<points; i++) {
-      int16_t sample = sineValues[int(toneIdx)] / state.volume;
-      mixSample(&buffer->data[i], sample, fade);
-      toneIdx += state.step;
-      if ((unsigned int)toneIdx >= DIM(sineValues))
-        toneIdx -= DIM(sineValues);
+      unsigned int idx = phase >> TONE_PHASE_INDEX_SHIFT;
+      int32_t frac = (phase >> TONE_PHASE_FRAC_SHIFT) & 0xFF;
+      int32_t value = sineValues[idx] + (((sineValues[(idx+1) & (DIM(sineValues)-1)] - sineValues[idx]) * frac) >> 8);
+      buffer->data[i] += (value * gain) >> AUDIO_GAIN_SHIFT;
+      phase += state.step;
     }
 
     if (remainingDuration > AUDIO_BUFFER_DURATION) {
       state.duration += AUDIO_BUFFER_DURATION;
-      state.idx = toneIdx;
+      state.phase = phase;
       return AUDIO_BUFFER_SIZE;
     }
     else {
@@ -699,33 +1039,38 @@ int ToneContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
 void AudioQueue::wakeup()
 {
   int result;
+
+#if defined(SDCARD) && defined(AUDIO_CACHE_SIZE)
+  if (audioCache.prefillRequested) {
+    audioCache.prefill();
+  }
+#endif
+
   AudioBuffer *buffer = getEmptyBuffer();
   if (buffer) {
-    unsigned int fade = 0;
     int size = 0;
 
-    // write silence in the buffer
-    for (uint32_t i=0; i<AUDIO_BUFFER_SIZE; i++) {
-#if defined(SIMU_AUDIO)
-      buffer->data[i] = 0x8000; /* silence */
-#else
-      buffer->data[i] = 0x8000 >> 4; /* silence */
-#endif
-    }
+    mix.clear();
+
+    // the vario and the background music are ducked while a voice prompt is played
+    int32_t duckingTarget = (normalContext.fragment.type == FRAGMENT_FILE ? AUDIO_DUCKING_GAIN : AUDIO_GAIN_UNITY);
+    if (ducking > duckingTarget)
+      ducking = max<int32_t>(ducking - AUDIO_DUCKING_STEP, duckingTarget);
+    else if (ducking < duckingTarget)
+      ducking = min<int32_t>(ducking + AUDIO_DUCKING_STEP, duckingTarget);
 
     // mix the priority context (only tones)
-    result = priorityContext.mixBuffer(buffer, g_eeGeneral.beepVolume, fade);
+    result = priorityContext.mixBuffer(&mix, getToneVolumeGain(g_eeGeneral.beepVolume));
     if (result > 0) {
       size = result;
-      fade += 1;
     }
 
     // mix the normal context (tones and wavs)
     if (normalContext.fragment.type == FRAGMENT_TONE) {
-      result = normalContext.tone.mixBuffer(buffer, g_eeGeneral.beepVolume, fade);
+      result = normalContext.tone.mixBuffer(&mix, getToneVolumeGain(g_eeGeneral.beepVolume));
     }
     else if (normalContext.fragment.type == FRAGMENT_FILE) {
-      result = normalContext.wav.mixBuffer(buffer, g_eeGeneral.wavVolume, fade);
+      result = normalContext.wav.mixBuffer(&mix, getWavVolumeGain(g_eeGeneral.wavVolume));
       if (result < 0) {
         normalContext.wav.clear();
       }
@@ -735,7 +1080,6 @@ void AudioQueue::wakeup()
     }
     if (result > 0) {
       size = max(size, result);
-      fade += 1;
     }
     else {
       CoEnterMutexSection(audioMutex);
@@ -749,15 +1093,14 @@ void AudioQueue::wakeup()
     }
 
     // mix the vario context
-    result = varioContext.mixBuffer(buffer, g_eeGeneral.varioVolume, fade);
+    result = varioContext.mixBuffer(&mix, (getToneVolumeGain(g_eeGeneral.varioVolume) * ducking) >> AUDIO_GAIN_SHIFT);
     if (result > 0) {
       size = max(size, result);
-      fade += 1;
     }
 
     // mix the background context
     if (isFunctionActive(FUNCTION_BACKGND_MUSIC) && !isFunctionActive(FUNCTION_BACKGND_MUSIC_PAUSE)) {
-      result = backgroundContext.mixBuffer(buffer, g_eeGeneral.backgroundVolume, fade);
+      result = backgroundContext.mixBuffer(&mix, (getWavVolumeGain(g_eeGeneral.backgroundVolume) * ducking) >> AUDIO_GAIN_SHIFT);
       if (result > 0) {
         size = max(size, result);
       }
@@ -765,6 +1108,7 @@ void AudioQueue::wakeup()
 
     // push the buffer if needed
     if (size > 0) {
+      mix.convert(buffer, size);
       __disable_irq();
       // TRACE("pushing buffer %d\n", bufferWIdx);
       bufferWIdx = nextBufferIdx(bufferWIdx);
@@ -807,6 +1151,19 @@ bool AudioQueue::isPlaying(uint8_t id)
   return false;
 }
 
+#if defined(SDCARD) && defined(AUDIO_CACHE_SIZE)
+bool AudioQueue::isCacheEntryPlayed(const AudioCacheEntry * entry)
+{
+  if (normalContext.fragment.type == FRAGMENT_FILE && normalContext.wav.state.cached == entry && normalContext.wav.state.size > 0)
+    return true;
+
+  if (backgroundContext.fragment.type == FRAGMENT_FILE && backgroundContext.state.cached == entry && backgroundContext.state.size > 0)
+    return true;
+
+  return false;
+}
+#endif
+
 void AudioQueue::playTone(uint16_t freq, uint16_t len, uint16_t pause, uint8_t flags, int8_t freqIncr)
 {
 #if defined(SIMU) && !defined(SIMU_AUDIO)
@@ -888,6 +1245,11 @@ void AudioQueue::playFile(const char *filename, uint8_t flags, uint8_t id)
     return;
   }
 
+  if (!isAudioFileAvailable(filename)) {
+    TRACE("playFile(\"%s\"): not in the catalog", filename);
+    return;
+  }
+
   CoEnterMutexSection(audioMutex);
 
   if (flags & PLAY_BACKGROUND) {
@@ -67,6 +67,29 @@ struct AudioBuffer {
   uint8_t  state;
 };
 
+#define AUDIO_GAIN_SHIFT      12
+#define AUDIO_GAIN_UNITY      (1 << AUDIO_GAIN_SHIFT)
+#if !defined(AUDIO_DUCKING)
+  #define AUDIO_DUCKING       50      // the % of the vario and background volumes while a voice prompt is played
+#endif
+#define AUDIO_DUCKING_GAIN    (AUDIO_DUCKING * AUDIO_GAIN_UNITY / 100)
+#define AUDIO_DUCKING_STEP    (AUDIO_GAIN_UNITY / 8)   // the gain change of each buffer when ducking starts / ends
+
+// The contexts are added with their gains in this buffer, which is saturated and converted to the DAC format once
+struct AudioMixBuffer {
+  int32_t data[AUDIO_BUFFER_SIZE];
+
+  inline void clear()
+  {
+    memset(data, 0, sizeof(data));
+  }
+
+  void convert(AudioBuffer * buffer, int size) const;
+};
+
+int32_t getToneVolumeGain(int volume);
+int32_t getWavVolumeGain(int volume);
+
 enum FragmentTypes {
   FRAGMENT_EMPTY,
   FRAGMENT_TONE,
@@ -100,9 +123,9 @@ class ToneContext {
     AudioFragment fragment;
 
     struct {
-      double step;
-      double idx;
-      float  volume;
+      uint32_t step;    // the phase increment of each sample, a whole period is 2^32
+      uint32_t phase;
+      int32_t  gain;    // the louder low frequencies, 1.0 = AUDIO_GAIN_UNITY
       uint16_t freq;
       uint16_t duration;
       uint16_t pause;
@@ -119,9 +142,57 @@ class ToneContext {
       memset(this, 0, sizeof(ToneContext));
     }
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int mixBuffer(AudioMixBuffer *buffer, int32_t gain);
+};
+
+// The read-ahead of each WAV context, a power of 2 which holds more than 10ms of 48kHz PCM16 samples.
+// It is refilled when half empty: the Taranis reads a file about every other buffer, the other boards
+// keep 1kB per context
+#if defined(PCBTARANIS)
+  #define WAV_BUFFER_SIZE     2048
+#else
+  #define WAV_BUFFER_SIZE     1024
+#endif
+#define WAV_READ_ALIGN        512     // the SD card sector
+#define WAV_STEP_SHIFT        16
+
+extern uint16_t wavUnderruns;
+
+#if defined(AUDIO_CACHE_SIZE)
+#if !defined(AUDIO_CACHE_SLOTS)
+  #define AUDIO_CACHE_SLOTS   8
+#endif
+#define AUDIO_CACHE_SLOT_SIZE (AUDIO_CACHE_SIZE / AUDIO_CACHE_SLOTS)
+
+// A small prompt kept in RAM. The samples are kept as they are in the data chunk of the file: an
+// A-law / mu-law sample is decoded by a table lookup when played, and takes half the room of PCM16
+struct AudioCacheEntry {
+  char     file[AUDIO_FILENAME_MAXLEN+1];
+  uint8_t  codec;
+  uint32_t freq;
+  uint32_t size;      // 0 when the entry is free
+  uint32_t lastUse;
+  uint8_t  data[AUDIO_CACHE_SLOT_SIZE];
 };
 
+// Only modified from the audio task
+class AudioCache {
+  public:
+    AudioCacheEntry entries[AUDIO_CACHE_SLOTS];
+    uint32_t useCounter;
+    uint16_t hits;
+    uint16_t misses;
+    volatile bool prefillRequested;
+
+    void clear();
+    const AudioCacheEntry * find(const char * file);
+    AudioCacheEntry * allocate(const char * file);
+    void prefill();
+};
+
+extern AudioCache audioCache;
+#endif
+
 class WavContext {
   public:
     AudioFragment fragment;
@@ -130,9 +201,16 @@ class WavContext {
       FIL      file;
       uint8_t  codec;
       uint32_t freq;
-      uint32_t size;
-      uint8_t  resampleRatio;
-      uint16_t readSize;
+      uint32_t size;        // the samples data not read yet from the file
+      uint32_t step;        // the input samples for one output sample, 1.0 = 1 << WAV_STEP_SHIFT
+      uint32_t position;    // the position of the output sample between the 2 input samples
+      int16_t  samples[2];
+      uint32_t readPos;     // the positions in data[] never wrap, the file offsets modulo WAV_READ_ALIGN
+      uint32_t writePos;
+      uint8_t  data[WAV_BUFFER_SIZE];
+#if defined(AUDIO_CACHE_SIZE)
+      const AudioCacheEntry * cached;   // the samples are copied from this entry instead of read from the file
+#endif
     } state;
 
     inline void clear()
@@ -140,7 +218,13 @@ class WavContext {
       fragment.clear();
     }
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int mixBuffer(AudioMixBuffer *buffer, int32_t gain);
+
+  protected:
+    FRESULT open();
+    void close();
+    FRESULT readAhead();
+    bool readSample(int16_t & sample);
 };
 
 class MixedContext {
@@ -151,7 +235,7 @@ class MixedContext {
       WavContext wav;
     };
 
-    int mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade);
+    int mixBuffer(AudioMixBuffer *buffer, int32_t gain);
 };
 
 bool dacQueue(AudioBuffer *buffer);
@@ -185,6 +269,10 @@ class AudioQueue {
 
     bool isPlaying(uint8_t id);
 
+#if defined(AUDIO_CACHE_SIZE)
+    bool isCacheEntryPlayed(const AudioCacheEntry * entry);
+#endif
+
     bool started()
     {
       return state;
@@ -243,6 +331,9 @@ class AudioQueue {
     ToneContext  priorityContext;
     ToneContext  varioContext;
 
+    AudioMixBuffer mix;
+    int32_t ducking;    // the gain of the vario and background contexts
+
     AudioBuffer buffers[AUDIO_BUFFER_COUNT];
     uint8_t bufferRIdx;
     uint8_t bufferWIdx;
@@ -385,6 +476,39 @@ void pushPrompt(uint16_t prompt, uint8_t id=0);
 
 char * getAudioPath(char * path);
 
+#define AUDIO_CATALOG_SLOTS   512     // a power of 2
+
+// The .wav files of one sound directory, kept as 32bit hashes of their lower case names in an open
+// addressing table, so that a prompt is found without any string compare or SD card access. A hash
+// collision would make a missing prompt look present, and silence the tone which replaces it: with 32bit
+// hashes and a few hundred files, its probability is below 1e-7. When the catalog is incomplete, the
+// files are looked for on the SD card
+class AudioCatalog {
+  public:
+    char     path[AUDIO_FILENAME_MAXLEN+1];
+    uint16_t count;
+    bool     complete;    // false when the directory couldn't be scanned or has more files than the table can hold
+    uint32_t hashes[AUDIO_CATALOG_SLOTS];
+
+    inline void clear()
+    {
+      memset(this, 0, sizeof(AudioCatalog));
+    }
+
+    void load(const char * directory);
+    bool contains(const char * name) const;
+
+  protected:
+    void add(const char * name);
+};
+
+extern AudioCatalog soundsAudioCatalog;
+extern AudioCatalog systemAudioCatalog;
+extern AudioCatalog modelAudioCatalog;
+
+bool isAudioFileAvailable(const char * filename);
+FRESULT readWavHeader(FIL * file, uint8_t * header/*at least 264 bytes long*/, uint8_t & codec, uint32_t & freq, uint32_t & size);
+
 void referenceSystemAudioFiles();
 void referenceModelAudioFiles();
 
@@ -0,0 +1,297 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "bench.h"
+
+// Runs the stages of the mixer pipeline on synthetic models, without the main thread of the simulator,
+// and reports the duration of each stage in ns per iteration, as CSV on stdout (the traces go to stderr):
+//   model,stage,iterations,ns_per_iteration
+// Usage: bench [iterations] [model...]
+//        bench lua-alloc [iterations]   compares the Lua allocators, see lua_alloc.cpp
+//        bench telemetry-replay [-d] LOGFILE [rounds]   replays a sport.log, see telemetry_replay.cpp
+//        bench fades [fades]   the worst mixer cycle during the fades, see fade.cpp
+//        bench lua-load [iterations]   loads a Lua script from its source and from its bytecode, see lua_load.cpp
+//        bench sport [rounds]   decodes a S.Port stream through the telemetry stages, see sport.cpp
+
+#define BENCH_DEFAULT_ITERATIONS            1000000
+#define BENCH_LUA_ALLOC_DEFAULT_ITERATIONS  100
+#define BENCH_REPLAY_DEFAULT_ROUNDS         100
+#define BENCH_FADES_DEFAULT_COUNT           20
+#define BENCH_LUA_LOAD_DEFAULT_ITERATIONS   100
+#define BENCH_SPORT_DEFAULT_ROUNDS          20000
+
+static const char * const benchStagesNames[BENCH_STAGE_COUNT] = {
+  "expos",
+  "logical_switches",
+  "curves",
+  "mixes",
+  "lua",
+  "mixer"
+};
+
+static int16_t benchSticks[NUM_STICKS+NUM_POTS];
+
+uint16_t anaIn(uint8_t chan)
+{
+  if (chan < NUM_STICKS+NUM_POTS)
+    return benchSticks[chan];
+  else
+    return 0;
+}
+
+// The sticks and pots follow triangles of different periods, the first switch toggles every 100 iterations
+void benchMoveSticks(uint32_t iteration)
+{
+  for (uint8_t i=0; i<NUM_STICKS+NUM_POTS; i++) {
+    uint32_t period = 2 * (64 + 16*i);
+    uint32_t phase = iteration % period;
+    int16_t value = (phase < period/2 ? phase : period - phase) * 2 * RESX / period * 2 - RESX;
+    benchSticks[i] = value;
+    calibratedStick[i] = value;
+  }
+  if (iteration % 100 == 0) {
+    simuSetSwitch(0, (iteration / 100) & 1 ? 1 : -1);
+  }
+}
+
+void benchModelReset()
+{
+  memclear(&g_model, sizeof(g_model));
+  memclear(benchSticks, sizeof(benchSticks));
+  memclear(anas, sizeof(anas));
+  memclear(channelOutputs, sizeof(channelOutputs));
+  memclear(chans, sizeof(chans));
+  memclear(ex_chans, sizeof(ex_chans));
+  memclear(act, sizeof(act));
+  memclear(swOn, sizeof(swOn));
+  extern uint8_t s_mixer_first_run_done;
+  s_mixer_first_run_done = false;
+  mixerCurrentFlightMode = 0;
+  lastFlightMode = 255;
+  logicalSwitchesReset();
+#if defined(CPUARM)
+  modelCachesInvalidate();
+#endif
+}
+
+static void benchRunStage(uint8_t stage, uint32_t iteration)
+{
+  switch (stage) {
+    case BENCH_STAGE_EXPOS:
+      applyExpos(anas, e_perout_mode_normal);
+      break;
+    case BENCH_STAGE_LOGICAL_SWITCHES:
+#if defined(CPUARM)
+      // the mixer evaluates the logical switches with the sources snapshot started
+      sourcesSnapshotStart();
+      evalLogicalSwitches(true);
+      sourcesSnapshotStop();
+#endif
+      break;
+    case BENCH_STAGE_CURVES:
+#if defined(XCURVES)
+      applyCustomCurve(benchSticks[0], iteration % MAX_CURVES);
+#endif
+      break;
+    case BENCH_STAGE_MIXES:
+#if defined(CPUARM)
+      evalFlightModeMixes(e_perout_mode_normal, 1);
+#else
+      perOut(e_perout_mode_normal, 1);
+#endif
+      break;
+    case BENCH_STAGE_LUA:
+#if defined(LUA_MODEL_SCRIPTS)
+      luaTask(0, RUN_MIX_SCRIPT, false);
+#endif
+      break;
+    case BENCH_STAGE_MIXER:
+      evalMixes(1);
+      break;
+  }
+}
+
+static uint64_t benchNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static bool benchModelSelected(const char * name, int argc, char ** argv)
+{
+  if (argc <= 2)
+    return true;
+  for (int i=2; i<argc; i++) {
+    if (!strcmp(argv[i], name))
+      return true;
+  }
+  return false;
+}
+
+// The results are written on the stdout of the process. The traces of the firmware are written on
+// stdout too, they are moved to stderr
+static FILE * benchOpenResults()
+{
+  FILE * results = fdopen(dup(STDOUT_FILENO), "w");
+  fflush(stdout);
+  dup2(STDERR_FILENO, STDOUT_FILENO);
+  return results;
+}
+
+int main(int argc, char ** argv)
+{
+  if (argc > 1 && !strcmp(argv[1], "lua-alloc")) {
+    uint32_t iterations = (argc > 2 ? strtoul(argv[2], NULL, 10) : BENCH_LUA_ALLOC_DEFAULT_ITERATIONS);
+    return benchLuaAllocators(stdout, iterations);
+  }
+
+  if (argc > 1 && !strcmp(argv[1], "telemetry-replay")) {
+    bool dProtocol = (argc > 2 && !strcmp(argv[2], "-d"));
+    int arg = (dProtocol ? 3 : 2);
+    if (argc <= arg) {
+      fprintf(stderr, "usage: %s telemetry-replay [-d] LOGFILE [rounds]\n", argv[0]);
+      return 1;
+    }
+    uint32_t rounds = (argc > arg+1 ? strtoul(argv[arg+1], NULL, 10) : BENCH_REPLAY_DEFAULT_ROUNDS);
+    FILE * results = benchOpenResults();
+    simuInit();
+    int result = benchTelemetryReplay(results, argv[arg], rounds, dProtocol);
+    fclose(results);
+    return result;
+  }
+
+  if (argc > 1 && !strcmp(argv[1], "fades")) {
+    uint32_t fades = (argc > 2 ? strtoul(argv[2], NULL, 10) : BENCH_FADES_DEFAULT_COUNT);
+    FILE * results = benchOpenResults();
+    simuInit();
+    int result = benchFades(results, fades);
+    fclose(results);
+    return result;
+  }
+
+  if (argc > 1 && !strcmp(argv[1], "lua-load")) {
+    uint32_t iterations = (argc > 2 ? strtoul(argv[2], NULL, 10) : BENCH_LUA_LOAD_DEFAULT_ITERATIONS);
+    FILE * results = benchOpenResults();
+    simuInit();
+    int result = benchLuaLoads(results, iterations);
+    fclose(results);
+    return result;
+  }
+
+  if (argc > 1 && !strcmp(argv[1], "sport")) {
+    uint32_t rounds = (argc > 2 ? strtoul(argv[2], NULL, 10) : BENCH_SPORT_DEFAULT_ROUNDS);
+    FILE * results = benchOpenResults();
+    simuInit();
+    int result = benchSport(results, rounds);
+    fclose(results);
+    return result;
+  }
+
+  uint32_t iterations = (argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_ITERATIONS);
+  if (iterations == 0) {
+    fprintf(stderr, "usage: %s [iterations] [model...]\n", argv[0]);
+    return 1;
+  }
+
+  // the SD card is a temporary directory, for the Lua scripts
+  char sdDirectory[] = "/tmp/opentx-bench-XXXXXX";
+  if (!mkdtemp(sdDirectory)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  strcpy(simuSdDirectory, sdDirectory);
+  char path[sizeof(simuSdDirectory)+32];
+  sprintf(path, "%s" SCRIPTS_PATH, sdDirectory);
+  mkdir(path, 0755);
+  sprintf(path, "%s" SCRIPTS_MIXES_PATH, sdDirectory);
+  mkdir(path, 0755);
+
+  FILE * results = benchOpenResults();
+
+  simuInit();
+
+  // the duration of the sticks moves alone, removed from the durations of the stages
+  uint64_t start = benchNow();
+  for (uint32_t i=0; i<iterations; i++) {
+    benchMoveSticks(i);
+  }
+  uint64_t sticksDuration = benchNow() - start;
+
+  fprintf(results, "model,stage,iterations,ns_per_iteration\n");
+
+  for (uint8_t m=0; m<benchModelsCount; m++) {
+    const BenchModel & model = benchModels[m];
+    if (!benchModelSelected(model.name, argc, argv))
+      continue;
+    for (uint8_t stage=0; stage<BENCH_STAGE_COUNT; stage++) {
+      if (!(model.stages & (1 << stage)))
+        continue;
+      benchModelReset();
+      model.load();
+      // the model runs a few cycles before, as on the radio
+      for (uint32_t i=0; i<100; i++) {
+        benchMoveSticks(i);
+        evalMixes(1);
+      }
+      uint64_t start = benchNow();
+      for (uint32_t i=0; i<iterations; i++) {
+        benchMoveSticks(i);
+        benchRunStage(stage, i);
+      }
+      int64_t duration = benchNow() - start - sticksDuration;
+      fprintf(results, "%s,%s,%u,%.1f\n", model.name, benchStagesNames[stage], iterations, (double)max<int64_t>(0, duration) / iterations);
+      fflush(results);
+    }
+  }
+
+  sprintf(path, "%s" SCRIPTS_MIXES_PATH "/bench.lua", sdDirectory);
+  remove(path);
+  sprintf(path, "%s" SCRIPTS_MIXES_PATH "/bench.luac", sdDirectory);
+  remove(path);
+  sprintf(path, "%s" SCRIPTS_MIXES_PATH, sdDirectory);
+  rmdir(path);
+  sprintf(path, "%s" SCRIPTS_PATH, sdDirectory);
+  rmdir(path);
+  rmdir(sdDirectory);
+  fclose(results);
+  return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#define SWAP_DEFINED
+#include "opentx.h"
+
+// The stages of the mixer pipeline which are measured, each one is run alone once per iteration
+enum BenchStages {
+  BENCH_STAGE_EXPOS,
+  BENCH_STAGE_LOGICAL_SWITCHES,
+  BENCH_STAGE_CURVES,
+  BENCH_STAGE_MIXES,
+  BENCH_STAGE_LUA,
+  BENCH_STAGE_MIXER,
+  BENCH_STAGE_COUNT
+};
+
+#define BENCH_STAGE(x)    (1 << BENCH_STAGE_##x)
+#define BENCH_STAGES_ALL  (BENCH_STAGE(EXPOS) | BENCH_STAGE(LOGICAL_SWITCHES) | BENCH_STAGE(MIXES) | BENCH_STAGE(MIXER))
+
+// A synthetic model, built from code
+struct BenchModel {
+  const char * name;
+  void (*load)();
+  uint8_t stages;
+};
+
+extern const BenchModel benchModels[];
+extern const uint8_t benchModelsCount;
+
+void benchModelReset();
+void benchMoveSticks(uint32_t iteration);
+int benchLuaAllocators(FILE * results, uint32_t iterations);
+int benchTelemetryReplay(FILE * results, const char * filename, uint32_t rounds, bool dProtocol);
+int benchFades(FILE * results, uint32_t fades);
+int benchLuaLoads(FILE * results, uint32_t iterations);
+int benchSport(FILE * results, uint32_t rounds);
+
+#endif // _BENCH_H_
@@ -0,0 +1,130 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "bench.h"
+
+#if defined(CPUARM)
+// Worst mixer cycle duration during fades, between a model with all its channels evaluated again for each
+// flight mode (the original loop) and the same model with only its flight mode dependent channels evaluated
+// again, as CSV on stdout:
+//   evaluation,fades,worst_cycle_ns
+// Each cycle duration is the shortest of all the fades, to remove the host noise
+
+static uint64_t benchFadeNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void benchFadeModel()
+{
+  benchModelReset();
+  g_model.flightModeData[1].swtch = TR(SWSRC_THR, SWSRC_SA0);
+  g_model.flightModeData[1].fadeIn = 10;
+  g_model.flightModeData[1].fadeOut = 10;
+  for (int i=0; i<NUM_STICKS; i++) {
+    ExpoData * ed = expoAddress(i);
+    ed->mode = 3;
+    ed->chn = i;
+    ed->weight = 100;
+#if defined(VIRTUALINPUTS)
+    ed->srcRaw = MIXSRC_Rud + i;
+#endif
+  }
+  // 2 lines per channel, the first 2 channels have their own settings in the flight mode 1
+  for (int i=0; i<MAX_MIXERS; i++) {
+    MixData * md = &g_model.mixData[i];
+    md->destCh = i / (MAX_MIXERS/NUM_CHNOUT);
+    md->srcRaw = (md->destCh > 2 && (i & 1)) ? MIXSRC_CH1 + 2 + i % (md->destCh-2) : MIXSRC_Rud + i % NUM_STICKS;
+    md->weight = 50;
+    md->carryTrim = 1;
+  }
+  g_model.mixData[0].flightModes = 2;
+  g_model.mixData[2].flightModes = 1;
+  mixerPlanUpdate();
+}
+
+int benchFades(FILE * results, uint32_t fades)
+{
+  static const char * const names[2] = { "all_channels", "flight_mode_channels" };
+  static uint32_t durations[200];
+
+  fprintf(results, "evaluation,fades,worst_cycle_ns\n");
+
+  for (int run=0; run<2; run++) {
+    benchFadeModel();
+    if (mixerPlan.state != MIXER_PLAN_ORDERED) {
+      fprintf(stderr, "The fades model is not ordered\n");
+      return 1;
+    }
+    if (run == 0)
+      mixerPlan.fadeChannels = (bitfield_channels_t)-1;
+
+    for (int i=0; i<200; i++)
+      durations[i] = 0xffffffff;
+    for (uint32_t fade=0; fade<fades; fade++) {
+      for (int cycle=0; cycle<400; cycle++) {
+        if (cycle % 200 == 0)
+          simuSetSwitch(0, cycle ? -1 : 1);
+        uint64_t start = benchFadeNow();
+        evalMixes(1);
+        uint32_t duration = benchFadeNow() - start;
+        if (cycle < 200 && duration < durations[cycle])
+          durations[cycle] = duration;
+      }
+    }
+
+    uint32_t worst = 0;
+    for (int i=0; i<200; i++) {
+      if (durations[i] > worst)
+        worst = durations[i];
+    }
+    fprintf(results, "%s,%u,%u\n", names[run], fades, worst);
+    fflush(results);
+  }
+
+  return 0;
+}
+#else
+int benchFades(FILE * results, uint32_t fades)
+{
+  fprintf(stderr, "The fades are only measured on the ARM boards\n");
+  return 1;
+}
+#endif // #if defined(CPUARM)
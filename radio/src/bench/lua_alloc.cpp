@@ -0,0 +1,215 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <malloc.h>
+#include <map>
+#include <vector>
+#include "bench.h"
+
+#if defined(LUA)
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+#include "bin_allocator.h"
+#include "pool_allocator.h"
+
+// Records the allocations of a Lua workload with the default allocator, then replays them against each
+// allocator: the replay measures the allocator alone, and the bytes it takes for the blocks (the slots
+// sizes, or the blocks sizes with their header in the libc heap), as CSV on stdout:
+//   allocator,calls,ns_per_call,peak_bytes,libc_peak_bytes
+
+// A telemetry-like script: a few tables per sensor, strings formatted at each run, compiled each time
+static const char * const benchLuaAllocScript =
+  "local sensors = {}\n"
+  "for i=1,32 do\n"
+  "  sensors[i] = { name='S'..i, value=i*3, history={} }\n"
+  "end\n"
+  "for r=1,10 do\n"
+  "  for i=1,32 do\n"
+  "    local s = sensors[i]\n"
+  "    s.history[#s.history+1] = s.value + r\n"
+  "    s.label = s.name .. ':' .. (s.value + r)\n"
+  "  end\n"
+  "end\n"
+  "local labels = {}\n"
+  "for i=1,32 do labels[#labels+1] = sensors[i].label end\n"
+  "return #labels\n";
+
+struct BenchAllocCall {
+  int32_t block;       // the block reallocated or freed, -1 for a new block
+  int32_t result;      // the block returned, -1 for a free
+  uint32_t osize;
+  uint32_t nsize;
+};
+
+static std::vector<BenchAllocCall> benchAllocCalls;
+static std::map<void *, int32_t> benchAllocBlocks;
+static int32_t benchAllocBlocksCount = 0;
+
+static void * benchRecordAlloc(void * ud, void * ptr, size_t osize, size_t nsize)
+{
+  BenchAllocCall call;
+  call.block = -1;
+  call.result = -1;
+  call.osize = (ptr ? osize : 0);
+  call.nsize = nsize;
+  if (ptr) {
+    call.block = benchAllocBlocks[ptr];
+    benchAllocBlocks.erase(ptr);
+  }
+  void * res = l_alloc(ud, ptr, osize, nsize);
+  if (res) {
+    call.result = benchAllocBlocksCount++;
+    benchAllocBlocks[res] = call.result;
+  }
+  benchAllocCalls.push_back(call);
+  return res;
+}
+
+struct BenchAllocator {
+  const char * name;
+  lua_Alloc alloc;
+  size_t (*size)(void * ptr);   // the slot size of a block, 0 if it is in the libc heap
+};
+
+static size_t benchStdSize(void * ptr)
+{
+  return 0;
+}
+
+static size_t benchBinSize(void * ptr)
+{
+  return slots1.size(ptr) + slots2.size(ptr);
+}
+
+static size_t benchPoolSize(void * ptr)
+{
+  return poolAllocatorSize(ptr);
+}
+
+static const BenchAllocator benchAllocators[] = {
+  { "std", l_alloc, benchStdSize },
+  { "bin", bin_l_alloc, benchBinSize },
+  { "pool", pool_l_alloc, benchPoolSize },
+};
+
+static size_t benchLibcSize(void * ptr)
+{
+  return malloc_usable_size(ptr) + sizeof(size_t);
+}
+
+static uint64_t benchAllocNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int benchLuaAllocators(FILE * results, uint32_t iterations)
+{
+  lua_State * L = lua_newstate(benchRecordAlloc, NULL);
+  luaL_openlibs(L);
+  for (uint32_t i=0; i<iterations; i++) {
+    if (luaL_loadstring(L, benchLuaAllocScript) || lua_pcall(L, 0, 1, 0)) {
+      fprintf(stderr, "Lua error: %s\n", lua_tostring(L, -1));
+      lua_close(L);
+      return 1;
+    }
+    lua_pop(L, 1);
+  }
+  lua_close(L);
+
+  std::vector<void *> blocks(benchAllocBlocksCount);
+  fprintf(results, "allocator,calls,ns_per_call,peak_bytes,libc_peak_bytes\n");
+
+  // the workload frees all its blocks at the end, each replay starts with empty allocators
+  for (unsigned int a=0; a<DIM(benchAllocators); a++) {
+    const BenchAllocator & allocator = benchAllocators[a];
+
+    // the bytes taken by the blocks
+    uint32_t heap = 0, peak = 0, libc = 0, libcPeak = 0;
+    for (unsigned int i=0; i<benchAllocCalls.size(); i++) {
+      const BenchAllocCall & call = benchAllocCalls[i];
+      void * ptr = (call.block >= 0 ? blocks[call.block] : NULL);
+      if (ptr) {
+        size_t size = allocator.size(ptr);
+        if (!size) {
+          size = benchLibcSize(ptr);
+          libc -= size;
+        }
+        heap -= size;
+      }
+      void * res = allocator.alloc(NULL, ptr, call.osize, call.nsize);
+      if (res) {
+        size_t size = allocator.size(res);
+        if (!size) {
+          size = benchLibcSize(res);
+          libc += size;
+        }
+        heap += size;
+        blocks[call.result] = res;
+      }
+      peak = max(peak, heap);
+      libcPeak = max(libcPeak, libc);
+    }
+
+    // the same calls again, for the duration of the calls alone
+    uint64_t start = benchAllocNow();
+    for (unsigned int i=0; i<benchAllocCalls.size(); i++) {
+      const BenchAllocCall & call = benchAllocCalls[i];
+      void * res = allocator.alloc(NULL, call.block >= 0 ? blocks[call.block] : NULL, call.osize, call.nsize);
+      if (call.result >= 0) {
+        blocks[call.result] = res;
+      }
+    }
+    uint64_t duration = benchAllocNow() - start;
+
+    fprintf(results, "%s,%u,%.1f,%u,%u\n", allocator.name, (unsigned int)benchAllocCalls.size(), (double)duration / benchAllocCalls.size(), peak, libcPeak);
+    fflush(results);
+  }
+
+  return 0;
+}
+#else
+int benchLuaAllocators(FILE * results, uint32_t iterations)
+{
+  fprintf(stderr, "Lua is not enabled\n");
+  return 1;
+}
+#endif // #if defined(LUA)
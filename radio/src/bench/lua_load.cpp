@@ -0,0 +1,134 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench.h"
+
+#if defined(LUA)
+#include <lua.h>
+
+// Loads a Lua script from its source, which writes its bytecode, then from this bytecode, with the
+// firmware loader and a temporary SD card, and reports the duration of each load, as CSV on stdout:
+//   load,iterations,ns_per_load
+
+extern lua_State * L;
+extern void luaInit();
+
+static uint64_t benchLuaLoadNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static bool benchLuaLoadScript(const char * filename)
+{
+  if (luaLoadScriptFile(filename) != 0) {
+    fprintf(stderr, "Lua error: %s\n", lua_tostring(L, -1));
+    lua_pop(L, 1);
+    return false;
+  }
+  lua_pop(L, 1);
+  lua_gc(L, LUA_GCCOLLECT, 0);
+  return true;
+}
+
+int benchLuaLoads(FILE * results, uint32_t iterations)
+{
+  char sdDirectory[] = "/tmp/opentx-bench-XXXXXX";
+  if (!mkdtemp(sdDirectory)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  strcpy(simuSdDirectory, sdDirectory);
+  char source[sizeof(sdDirectory)+16], bytecode[sizeof(sdDirectory)+16];
+  sprintf(source, "%s/bench.lua", sdDirectory);
+  sprintf(bytecode, "%s/bench.luac", sdDirectory);
+
+  // 50 small functions, as a telemetry script
+  FILE * f = fopen(source, "w");
+  fprintf(f, "local t = {}\n");
+  for (int i=0; i<50; i++) {
+    fprintf(f, "t[%d] = function(a, b) if a > b then return a * %d + b else return { a, b, 'x%d' } end end\n", i, i, i);
+  }
+  fprintf(f, "local function run(a, b) return t[1](a, b) * 20 + b, #t end\n");
+  fprintf(f, "return { run=run }\n");
+  fclose(f);
+
+  luaInit();
+  int result = 0;
+  fprintf(results, "load,iterations,ns_per_load\n");
+
+  uint64_t duration = 0;
+  for (uint32_t i=0; i<iterations && result==0; i++) {
+    unlink(bytecode);
+    uint64_t start = benchLuaLoadNow();
+    if (!benchLuaLoadScript("/bench.lua"))
+      result = 1;
+    duration += benchLuaLoadNow() - start;
+  }
+  if (result == 0) {
+    fprintf(results, "source,%u,%.1f\n", iterations, (double)duration / iterations);
+    fflush(results);
+  }
+
+  duration = 0;
+  for (uint32_t i=0; i<iterations && result==0; i++) {
+    uint64_t start = benchLuaLoadNow();
+    if (!benchLuaLoadScript("/bench.lua"))
+      result = 1;
+    duration += benchLuaLoadNow() - start;
+  }
+  if (result == 0) {
+    fprintf(results, "bytecode,%u,%.1f\n", iterations, (double)duration / iterations);
+    fflush(results);
+  }
+
+  unlink(source);
+  unlink(bytecode);
+  rmdir(sdDirectory);
+  return result;
+}
+#else
+int benchLuaLoads(FILE * results, uint32_t iterations)
+{
+  fprintf(stderr, "Lua is not enabled\n");
+  return 1;
+}
+#endif // #if defined(LUA)
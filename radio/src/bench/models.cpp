@@ -0,0 +1,328 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include "bench.h"
+
+static void setExpo(uint8_t index, uint8_t stick, int8_t expo)
+{
+  ExpoData * ed = expoAddress(index);
+  ed->mode = 3;
+  ed->chn = stick;
+  ed->weight = 100;
+#if defined(VIRTUALINPUTS)
+  ed->srcRaw = MIXSRC_Rud + stick;
+  ed->curve.type = CURVE_REF_EXPO;
+  ed->curve.value = expo;
+#else
+  ed->curveMode = MODE_EXPO;
+  ed->curveParam = expo;
+#endif
+}
+
+static MixData * setMix(uint8_t index, uint8_t channel, int16_t source, int16_t weight)
+{
+  MixData * md = mixAddress(index);
+  md->destCh = channel;
+  md->srcRaw = source;
+  md->weight = weight;
+  return md;
+}
+
+static void setMixDifferential(MixData * md, int8_t value)
+{
+#if defined(XCURVES)
+  md->curve.type = CURVE_REF_DIFF;
+  md->curve.value = value;
+#else
+  md->curveMode = MODE_DIFFERENTIAL;
+  md->curveParam = value;
+#endif
+}
+
+static int16_t stickSource(uint8_t stick)
+{
+#if defined(VIRTUALINPUTS)
+  return MIXSRC_FIRST_INPUT + stick;
+#else
+  return MIXSRC_Rud + stick;
+#endif
+}
+
+static void loadSticksExpos()
+{
+  for (uint8_t i=0; i<NUM_STICKS; i++) {
+    setExpo(i, i, 20 + 10*i);
+  }
+}
+
+// All the mix lines, each channel mixes sticks, trims and the channels before it
+static void loadMaxMixesModel()
+{
+  loadSticksExpos();
+  for (uint8_t i=0; i<MAX_MIXERS; i++) {
+    uint8_t channel = i * NUM_CHNOUT / MAX_MIXERS;
+    int16_t source;
+    switch (i % 4) {
+      case 0:
+        source = stickSource(channel % NUM_STICKS);
+        break;
+      case 1:
+        source = (channel > 0 ? MIXSRC_CH1 + (i % channel) : MIXSRC_MAX);
+        break;
+      case 2:
+        source = MIXSRC_FIRST_TRIM + (i % NUM_STICKS);
+        break;
+      default:
+        source = MIXSRC_FIRST_POT + (i % NUM_POTS);
+        break;
+    }
+    MixData * md = setMix(i, channel, source, 25 + (i % 75));
+    md->offset = (i % 7) * 5;
+    md->carryTrim = (i % 3) == 0 ? 0 : 1;
+    md->mltpx = (i % 5) == 4 ? MLTPX_MUL : MLTPX_ADD;
+    if (i % 6 == 0)
+      setMixDifferential(md, 20);
+    if (i % 8 == 0)
+      md->swtch = TR(SWSRC_ID2, SWSRC_SA2);
+    if (i % 16 == 5)
+      md->speedUp = md->speedDown = 10;
+  }
+}
+
+// All the logical switches, each channel is switched by one of them
+static void loadLogicalSwitchesModel()
+{
+  loadSticksExpos();
+  for (uint8_t i=0; i<NUM_LOGICAL_SWITCH; i++) {
+    LogicalSwitchData * cs = lswAddress(i);
+    switch (i % 8) {
+      case 0:
+        cs->func = LS_FUNC_VPOS;
+        cs->v1 = MIXSRC_Rud + (i % NUM_STICKS);
+        cs->v2 = (i % 5) * 20 - 40;
+        break;
+      case 1:
+        cs->func = LS_FUNC_APOS;
+        cs->v1 = MIXSRC_Rud + (i % NUM_STICKS);
+        cs->v2 = 50;
+        break;
+      case 2:
+#if defined(CPUARM)
+        cs->func = LS_FUNC_RANGE;
+        cs->v3 = 30;
+#else
+        cs->func = LS_FUNC_ANEG;
+#endif
+        cs->v1 = MIXSRC_FIRST_POT + (i % NUM_POTS);
+        cs->v2 = -30;
+        break;
+      case 3:
+        cs->func = LS_FUNC_AND;
+        cs->v1 = SWSRC_FIRST_LOGICAL_SWITCH + i - 3;
+        cs->v2 = SWSRC_FIRST_LOGICAL_SWITCH + i - 2;
+        break;
+      case 4:
+        cs->func = LS_FUNC_GREATER;
+        cs->v1 = MIXSRC_Rud + (i % NUM_STICKS);
+        cs->v2 = MIXSRC_Rud + ((i+1) % NUM_STICKS);
+        break;
+      case 5:
+        cs->func = LS_FUNC_DIFFEGREATER;
+        cs->v1 = MIXSRC_Rud + (i % NUM_STICKS);
+        cs->v2 = 10;
+        break;
+      case 6:
+        cs->func = LS_FUNC_STICKY;
+        cs->v1 = SWSRC_FIRST_LOGICAL_SWITCH + i - 6;
+        cs->v2 = SWSRC_FIRST_LOGICAL_SWITCH + i - 5;
+        break;
+      default:
+        cs->func = LS_FUNC_TIMER;
+        cs->v1 = 5;
+        cs->v2 = 5;
+        break;
+    }
+    if (i % 3 == 0)
+      cs->andsw = TR(SWSRC_ID0, SWSRC_SA0);
+    if (i % 5 == 0)
+      cs->delay = 5;
+    if (i % 7 == 0)
+      cs->duration = 5;
+  }
+  for (uint8_t ch=0; ch<NUM_CHNOUT; ch++) {
+    MixData * md = setMix(ch, ch, stickSource(ch % NUM_STICKS), 100);
+    md->swtch = SWSRC_FIRST_LOGICAL_SWITCH + (ch % NUM_LOGICAL_SWITCH);
+  }
+}
+
+#if defined(XCURVES)
+// All the curves with 17 smooth points, used by the inputs and the mix lines
+static void loadSmoothCurvesModel()
+{
+  for (uint8_t c=0; c<MAX_CURVES; c++) {
+    g_model.curves[c].type = (c & 1) ? CURVE_TYPE_CUSTOM : CURVE_TYPE_STANDARD;
+    g_model.curves[c].smooth = 1;
+    g_model.curves[c].points = 17 - 5;
+  }
+  loadCurves();
+  for (uint8_t c=0; c<MAX_CURVES; c++) {
+    int8_t * points = curveAddress(c);
+    for (uint8_t i=0; i<17; i++) {
+      points[i] = limit<int>(-100, (i - 8) * (10 + c) / 2 + (i & 1) * 5, 100);
+    }
+    if (g_model.curves[c].type == CURVE_TYPE_CUSTOM) {
+      for (uint8_t i=0; i<15; i++) {
+        points[17+i] = -100 + (i+1) * 200 / 16;
+      }
+    }
+  }
+  for (uint8_t i=0; i<NUM_STICKS; i++) {
+    setExpo(i, i, 0);
+    ExpoData * ed = expoAddress(i);
+    ed->curve.type = CURVE_REF_CUSTOM;
+    ed->curve.value = i + 1;
+  }
+  for (uint8_t ch=0; ch<NUM_CHNOUT; ch++) {
+    MixData * md = setMix(ch, ch, stickSource(ch % NUM_STICKS), 100);
+    md->curve.type = CURVE_REF_CUSTOM;
+    md->curve.value = NUM_STICKS + 1 + ch;
+  }
+}
+#endif
+
+// Two flight modes which fade in and out, the first channels have their own lines in each one
+static void loadFadesModel()
+{
+  g_model.flightModeData[1].swtch = TR(SWSRC_THR, SWSRC_SA0);
+  for (uint8_t p=0; p<2; p++) {
+    g_model.flightModeData[p].fadeIn = 10;
+    g_model.flightModeData[p].fadeOut = 10;
+    for (uint8_t i=0; i<NUM_STICKS; i++) {
+#if defined(PCBTARANIS)
+      g_model.flightModeData[p].trim[i].mode = 2*p;
+#endif
+      setTrimValue(p, i, 10*p - 5*i);
+    }
+  }
+  loadSticksExpos();
+  for (uint8_t i=0; i<MAX_MIXERS; i++) {
+    uint8_t channel = i * NUM_CHNOUT / MAX_MIXERS;
+    MixData * md = setMix(i, channel, (channel > 2 && (i & 1)) ? MIXSRC_CH1 + 2 + i % (channel-2) : stickSource(i % NUM_STICKS), 50);
+    md->carryTrim = 1;
+    if (channel < 4)
+      md->flightModes = 1 << (i & 1);
+  }
+}
+
+#if defined(GVARS)
+// The weights, offsets and differentials given by GVars, which have their own values in each flight mode
+static void loadGVarsModel()
+{
+  g_model.flightModeData[1].swtch = TR(SWSRC_THR, SWSRC_SA0);
+  for (uint8_t p=0; p<2; p++) {
+    for (uint8_t g=0; g<MAX_GVARS; g++) {
+      SET_GVAR(g, (p ? 10 : -10) * (g+1), p);
+    }
+  }
+  loadSticksExpos();
+  for (uint8_t i=0; i<NUM_STICKS; i++) {
+    expoAddress(i)->weight = GV1_SMALL + (i % MAX_GVARS);
+  }
+  for (uint8_t i=0; i<MAX_MIXERS; i++) {
+    uint8_t channel = i * NUM_CHNOUT / MAX_MIXERS;
+    MixData * md = setMix(i, channel, stickSource(i % NUM_STICKS), GV1_LARGE + (i % MAX_GVARS));
+    md->offset = GV1_LARGE + ((i+1) % MAX_GVARS);
+    if (i % 4 == 0)
+      setMixDifferential(md, GV1_SMALL + ((i+2) % MAX_GVARS));
+  }
+}
+#endif
+
+#if defined(LUA_MODEL_SCRIPTS)
+#define BENCH_LUA_SCRIPTS  3
+
+static const char * const benchLuaScript =
+  "local inputs = { { \"Src\", SOURCE }, { \"Rate\", VALUE, -100, 100, 50 } }\n"
+  "local outputs = { \"Out\", \"Acc\" }\n"
+  "local acc = 0\n"
+  "local function run(src, rate)\n"
+  "  acc = (acc + src) % 1024\n"
+  "  return src * rate / 100, acc\n"
+  "end\n"
+  "return { input=inputs, output=outputs, run=run }\n";
+
+// Lua mix scripts, their outputs are mixed in the channels
+static void loadLuaMixesModel()
+{
+  char path[sizeof(simuSdDirectory)+32];
+  sprintf(path, "%s" SCRIPTS_MIXES_PATH "/bench.lua", simuSdDirectory);
+  FILE * f = fopen(path, "w");
+  if (f) {
+    fputs(benchLuaScript, f);
+    fclose(f);
+  }
+  loadSticksExpos();
+  for (uint8_t i=0; i<BENCH_LUA_SCRIPTS; i++) {
+    ScriptData & sd = g_model.scriptsData[i];
+    strncpy(sd.file, "bench", sizeof(sd.file));
+    sd.inputs[0] = MIXSRC_Rud + i;
+    sd.inputs[1] = 10 * i;
+  }
+  for (uint8_t ch=0; ch<NUM_CHNOUT; ch++) {
+    setMix(ch, ch, MIXSRC_FIRST_LUA + (ch % BENCH_LUA_SCRIPTS) * MAX_SCRIPT_OUTPUTS + (ch & 1), 100);
+  }
+  LUA_LOAD_MODEL_SCRIPTS();
+  luaTask(0, RUN_MIX_SCRIPT, false);
+}
+#endif
+
+const BenchModel benchModels[] = {
+  { "max_mixes", loadMaxMixesModel, BENCH_STAGES_ALL },
+  { "logical_switches", loadLogicalSwitchesModel, BENCH_STAGES_ALL },
+#if defined(XCURVES)
+  { "smooth_curves", loadSmoothCurvesModel, BENCH_STAGES_ALL | BENCH_STAGE(CURVES) },
+#endif
+  { "fades", loadFadesModel, BENCH_STAGES_ALL },
+#if defined(GVARS)
+  { "gvars", loadGVarsModel, BENCH_STAGES_ALL },
+#endif
+#if defined(LUA_MODEL_SCRIPTS)
+  { "lua_mixes", loadLuaMixesModel, BENCH_STAGES_ALL | BENCH_STAGE(LUA) },
+#endif
+};
+
+const uint8_t benchModelsCount = DIM(benchModels);
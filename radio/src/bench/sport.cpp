@@ -0,0 +1,204 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "bench.h"
+
+#if defined(FRSKY_SPORT)
+// Decodes the S.Port frames of a receiver with a vario, a FAS, a FLVSS, a GPS and a RPM sensor in a
+// blank model, once to discover the sensors then for each round, and reports the duration of each
+// stage of the telemetry per frame, as CSV on stdout:
+//   stage,frames,ns_per_frame
+
+struct BenchSportFrame {
+  uint8_t physicalId;
+  uint16_t appId;
+  uint32_t data;
+};
+
+static const BenchSportFrame benchSportStream[] = {
+  { 0x98, RSSI_ID, 78 },
+  { 0x00, ALT_FIRST_ID, 12345 },
+  { 0x00, VARIO_FIRST_ID, (uint32_t)-25 },
+  { 0x22, CURR_FIRST_ID, 153 },
+  { 0x22, VFAS_FIRST_ID, 1240 },
+  { 0xA1, CELLS_FIRST_ID, 0x33633330 },
+  { 0x83, GPS_ALT_FIRST_ID, 10250 },
+  { 0x83, GPS_SPEED_FIRST_ID, 12000 },
+  { 0xE4, RPM_FIRST_ID, 3600 },
+  { 0x98, RSSI_ID, 77 },
+  { 0x00, ALT_FIRST_ID, 12350 },
+  { 0xA1, CELLS_FIRST_ID, 0x33833392 },
+};
+
+static uint8_t benchSportPackets[DIM(benchSportStream)][FRSKY_SPORT_PACKET_SIZE];
+
+static uint64_t benchSportNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void benchSportPacket(uint8_t * packet, const BenchSportFrame & frame)
+{
+  packet[0] = frame.physicalId;
+  packet[1] = 0x10; // DATA_FRAME
+  *((uint16_t *)(packet+2)) = frame.appId;
+  *((uint32_t *)(packet+4)) = frame.data;
+  short crc = 0;
+  for (int i=1; i<FRSKY_SPORT_PACKET_SIZE-1; i++) {
+    crc += packet[i];
+    crc += crc >> 8;
+    crc &= 0x00ff;
+  }
+  packet[FRSKY_SPORT_PACKET_SIZE-1] = 0xFF - crc;
+}
+
+static void benchSportReset()
+{
+  benchModelReset();
+  memclear(&frskyData, sizeof(frskyData));
+  for (int i=0; i<MAX_SENSORS; i++) {
+    telemetryItems[i].clear();
+  }
+}
+
+static void benchSportProcessPackets()
+{
+  for (unsigned int i=0; i<DIM(benchSportStream); i++) {
+    uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+    memcpy(packet, benchSportPackets[i], sizeof(packet));
+    processSportPacket(packet);
+  }
+}
+
+static void benchSportCalculatedSensor(int index, uint8_t formula, int8_t source1, int8_t source2)
+{
+  TelemetrySensor & sensor = g_model.telemetrySensors[index];
+  sensor.type = TELEM_TYPE_CALCULATED;
+  sensor.formula = formula;
+  sensor.calc.sources[0] = source1;
+  sensor.calc.sources[1] = source2;
+  sensor.unit = g_model.telemetrySensors[1].unit;
+  sensor.prec = g_model.telemetrySensors[1].prec;
+  sensor.label[0] = 'A' + index;
+}
+
+#if defined(PCBTARANIS)
+extern uint8_t telemetryProtocol;
+
+// the bytes of a frame on the bus, as the UART interrupt receives them
+static void benchSportPushBytes(const uint8_t * packet)
+{
+  telemetryPushByte(START_STOP);
+  for (uint8_t i=0; i<FRSKY_SPORT_PACKET_SIZE; i++) {
+    if (packet[i] == START_STOP || packet[i] == BYTESTUFF) {
+      telemetryPushByte(BYTESTUFF);
+      telemetryPushByte(packet[i] ^ STUFF_MASK);
+    }
+    else {
+      telemetryPushByte(packet[i]);
+    }
+  }
+}
+#endif
+
+static void benchSportResult(FILE * results, const char * stage, uint32_t frames, uint64_t duration)
+{
+  fprintf(results, "%s,%u,%.1f\n", stage, frames, (double)duration / frames);
+  fflush(results);
+}
+
+int benchSport(FILE * results, uint32_t rounds)
+{
+  for (unsigned int i=0; i<DIM(benchSportStream); i++) {
+    benchSportPacket(benchSportPackets[i], benchSportStream[i]);
+  }
+
+  fprintf(results, "stage,frames,ns_per_frame\n");
+
+  // the packets routed to the sensors
+  benchSportReset();
+  benchSportProcessPackets();
+  uint64_t start = benchSportNow();
+  for (uint32_t i=0; i<rounds; i++) {
+    benchSportProcessPackets();
+  }
+  benchSportResult(results, "packets", rounds*DIM(benchSportStream), benchSportNow() - start);
+
+  // an altitude received then a chain of calculated sensors against the sensors order evaluated
+  benchSportCalculatedSensor(10, TELEM_FORMULA_ADD, 12, 2);
+  benchSportCalculatedSensor(11, TELEM_FORMULA_MAX, 13, 0);
+  benchSportCalculatedSensor(12, TELEM_FORMULA_MIN, 2, 0);
+  modelCachesInvalidate();
+  start = benchSportNow();
+  for (uint32_t i=0; i<rounds; i++) {
+    uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+    BenchSportFrame frame = { 0x00, ALT_FIRST_ID, 1000 + (i & 1) };
+    benchSportPacket(packet, frame);
+    processSportPacket(packet);
+    telemetryEvalCalculated();
+  }
+  benchSportResult(results, "calculated_sensors", rounds, benchSportNow() - start);
+
+#if defined(PCBTARANIS)
+  // the frames delimited by the UART interrupt then parsed in bursts of 8 frames
+  benchSportReset();
+  telemetryProtocol = PROTOCOL_FRSKY_SPORT;
+  telemetryProcessFrames();
+  telemetryStats.reset();
+  start = benchSportNow();
+  for (uint32_t i=0; i<rounds; i++) {
+    for (unsigned int j=0; j<8; j++) {
+      benchSportPushBytes(benchSportPackets[j]);
+    }
+    telemetryProcessFrames();
+  }
+  benchSportResult(results, "pipeline", rounds*8, benchSportNow() - start);
+  telemetryStats.reset();
+#endif
+
+  return 0;
+}
+#else
+int benchSport(FILE * results, uint32_t rounds)
+{
+  fprintf(stderr, "The S.Port telemetry is not enabled\n");
+  return 1;
+}
+#endif // #if defined(FRSKY_SPORT)
@@ -0,0 +1,120 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "bench.h"
+#include "../targets/simu/telemetry_replay.h"
+
+#if defined(CPUARM) && defined(FRSKY)
+// Replays a sport.log recorded by the radio (SPORT_FILE_LOG) in a blank model, as fast as possible,
+// then writes the sensors discovered with their last value, as CSV on stdout, to be compared
+// between two versions:
+//   sensor,label,id,instance,value,prec
+// The duration of the replays is given on stderr, with the speed against the real time
+
+static uint64_t benchReplayNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void benchReplayReset(bool dProtocol)
+{
+  benchModelReset();
+  for (int i=0; i<MAX_SENSORS; i++) {
+    telemetryItems[i].clear();
+  }
+  if (dProtocol) {
+#if defined(PCBTARANIS)
+    g_model.moduleData[INTERNAL_MODULE].rfProtocol = RF_PROTO_OFF;
+    g_model.moduleData[EXTERNAL_MODULE].type = MODULE_TYPE_PPM;
+#endif
+    g_model.telemetryProtocol = PROTOCOL_FRSKY_D;
+  }
+}
+
+int benchTelemetryReplay(FILE * results, const char * filename, uint32_t rounds, bool dProtocol)
+{
+  if (!telemetryReplayLoad(filename)) {
+    fprintf(stderr, "%s: no telemetry recorded\n", filename);
+    return 1;
+  }
+
+  benchReplayReset(dProtocol);
+  telemetryReplayStart(1);
+  while (telemetryReplayRunning()) {
+    telemetryReplayStep();
+  }
+
+  fprintf(results, "sensor,label,id,instance,value,prec\n");
+  for (int i=0; i<MAX_SENSORS; i++) {
+    if (isTelemetryFieldAvailable(i)) {
+      const TelemetrySensor & sensor = g_model.telemetrySensors[i];
+      char label[TELEM_LABEL_LEN+1];
+      memset(label, 0, sizeof(label));
+      zchar2str(label, sensor.label, TELEM_LABEL_LEN);
+      fprintf(results, "%d,%s,0x%04X,%d,%d,%d\n", i, label, sensor.id, sensor.instance, telemetryItems[i].value, sensor.prec);
+    }
+  }
+  fflush(results);
+
+  // the decoding alone, the whole recording at each step
+  uint64_t start = benchReplayNow();
+  for (uint32_t i=0; i<rounds; i++) {
+    benchReplayReset(dProtocol);
+    telemetryReplayStart(0xFFFF);
+    while (telemetryReplayRunning()) {
+      telemetryReplayStep();
+    }
+  }
+  uint64_t duration = benchReplayNow() - start;
+  if (rounds > 0 && duration > 0) {
+    fprintf(stderr, "%u bytes, %.2fs of recording replayed %u times in %.1fms, %.0f times the real time\n",
+            telemetryReplayBytes(), telemetryReplayDuration() / 100.0, rounds, duration / 1000000.0,
+            10000000.0 * rounds * telemetryReplayDuration() / duration);
+  }
+
+  return 0;
+}
+#else
+int benchTelemetryReplay(FILE * results, const char * filename, uint32_t rounds, bool dProtocol)
+{
+  fprintf(stderr, "The FrSky telemetry is not enabled\n");
+  return 1;
+}
+#endif // #if defined(CPUARM) && defined(FRSKY)
@@ -3,6 +3,7 @@
 #include "opentx.h"
 #include "bin_allocator.h"
 
+#if defined(USE_BIN_ALLOCATOR) || defined(SIMU)
 
 BinAllocator_slots1 slots1;
 BinAllocator_slots2 slots2;
@@ -109,3 +110,5 @@ void *bin_l_alloc (void *ud, void *ptr, size_t osize, size_t nsize)
     return res;
   }
 }
+
+#endif // #if defined(USE_BIN_ALLOCATOR) || defined(SIMU)
@@ -67,12 +67,12 @@ typedef BinAllocator<29,200> BinAllocator_slots1;
 typedef BinAllocator<91,50> BinAllocator_slots2;
 #endif
 
-#if defined(USE_BIN_ALLOCATOR)
+#if defined(USE_BIN_ALLOCATOR) || defined(SIMU)
 extern BinAllocator_slots1 slots1;
 extern BinAllocator_slots2 slots2;
 
 // wrapper for our BinAllocator for Lua
 void *bin_l_alloc (void *ud, void *ptr, size_t osize, size_t nsize);
-#endif   //#if defined(USE_BIN_ALLOCATOR)
+#endif   //#if defined(USE_BIN_ALLOCATOR) || defined(SIMU)
 
 #endif //binallocator_h
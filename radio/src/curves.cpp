@@ -57,6 +57,12 @@ void loadCurves()
     }
     curveEnd[i] = tmp;
   }
+  curveSplinesInvalidate();
+  for (int i=0; i<MAX_CURVES; i++) {
+    if (g_model.curves[i].smooth) {
+      curveSplineLoad(i);
+    }
+  }
 }
 int8_t *curveAddress(uint8_t idx)
 {
@@ -152,54 +158,92 @@ s32 compute_tangent(CurveInfo *crv, int8_t *points, int i)
     return m;
 }
 
+CurveSpline curveSplines[MAX_CURVES];
+uint32_t curveSplinesValid;
+
+void curveSplineLoad(uint8_t idx)
+{
+  CurveInfo &crv = g_model.curves[idx];
+  CurveSpline &spline = curveSplines[idx];
+  int8_t *points = curveAddress(idx);
+  uint8_t count = crv.points+5;
+  bool custom = (crv.type == CURVE_TYPE_CUSTOM);
+
+  spline.count = count;
+  spline.monotone = true;
+  for (int i=0; i<count; i++) {
+    if (custom)
+      spline.x[i] = (i==0 ? -RESX : (i==count-1 ? RESX : calc100toRESX(points[count+i-1])));
+    else
+      spline.x[i] = -RESX + (i*2*RESX)/(count-1);
+    spline.y[i] = calc100toRESX(points[i]);
+    spline.m[i] = compute_tangent(&crv, points, i);
+    if (i > 0 && spline.x[i] < spline.x[i-1])
+      spline.monotone = false;
+  }
+
+  curveSplinesValid |= ((uint32_t)1 << idx);
+}
+
 /* The following is a hermite cubic spline.
    The basis functions can be found here:
    http://en.wikipedia.org/wiki/Cubic_Hermite_spline
    The tangents are computed via the 'cubic monotone' rules (allowing for local-maxima)
+   The points and tangents are taken from curveSplines[], rebuilt when the model is changed
 */
 int16_t hermite_spline(int16_t x, uint8_t idx)
 {
-  CurveInfo &crv = g_model.curves[idx];
-  int8_t *points = curveAddress(idx);
-  uint8_t count = crv.points+5;
-  bool custom = (crv.type == CURVE_TYPE_CUSTOM);
+  if (!(curveSplinesValid & ((uint32_t)1 << idx)))
+    curveSplineLoad(idx);
+
+  const CurveSpline &spline = curveSplines[idx];
+  uint8_t count = spline.count;
 
   if (x < -RESX)
     x = -RESX;
   else if (x > RESX)
     x = RESX;
 
-  for (int i=0; i<count-1; i++) {
-    s32 p0x, p3x;
-    if (custom) {
-      p0x = (i>0 ? calc100toRESX(points[count+i-1]) : -RESX);
-      p3x = (i<count-2 ? calc100toRESX(points[count+i]) : RESX);
+  // the first segment which contains x
+  int i;
+  if (spline.monotone) {
+    int lo = 0, hi = count-2;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (x <= spline.x[mid+1])
+        hi = mid;
+      else
+        lo = mid + 1;
     }
-    else {
-      p0x = -RESX + (i*2*RESX)/(count-1);
-      p3x = -RESX + ((i+1)*2*RESX)/(count-1);
-    }
-
-    if (x >= p0x && x <= p3x) {
-      s32 p0y = calc100toRESX(points[i]);
-      s32 p3y = calc100toRESX(points[i+1]);
-      s32 m0 = compute_tangent(&crv, points, i);
-      s32 m3 = compute_tangent(&crv, points, i+1);
-      s32 y;
-      s32 h = p3x - p0x;
-      s32 t = (h > 0 ? (MMULT * (x - p0x)) / h : 0);
-      s32 t2 = t * t / MMULT;
-      s32 t3 = t2 * t / MMULT;
-      s32 h00 = 2*t3 - 3*t2 + MMULT;
-      s32 h10 = t3 - 2*t2 + t;
-      s32 h01 = -2*t3 + 3*t2;
-      s32 h11 = t3 - t2;
-      y = p0y * h00 + h * (m0 * h10 / MMULT) + p3y * h01 + h * (m3 * h11 / MMULT);
-      y /= MMULT;
-      return y;
+    i = lo;
+  }
+  else {
+    for (i=0; i<count-1; i++) {
+      if (x >= spline.x[i] && x <= spline.x[i+1])
+        break;
     }
+    if (i == count-1)
+      return 0;
   }
-  return 0;
+
+  s32 p0x = spline.x[i];
+  s32 p3x = spline.x[i+1];
+  s32 p0y = spline.y[i];
+  s32 p3y = spline.y[i+1];
+  s32 m0 = spline.m[i];
+  s32 m3 = spline.m[i+1];
+  s32 y;
+  s32 h = p3x - p0x;
+  s32 t = (h > 0 ? (MMULT * (x - p0x)) / h : 0);
+  s32 t2 = t * t / MMULT;
+  s32 t3 = t2 * t / MMULT;
+  s32 h00 = 2*t3 - 3*t2 + MMULT;
+  s32 h10 = t3 - 2*t2 + t;
+  s32 h01 = -2*t3 + 3*t2;
+  s32 h11 = t3 - t2;
+  y = p0y * h00 + h * (m0 * h10 / MMULT) + p3y * h01 + h * (m3 * h11 / MMULT);
+  y /= MMULT;
+  return y;
 }
 #endif
 
@@ -420,7 +464,11 @@ unsigned int expou(unsigned int x, unsigned int k)
   return value>>8;
 }
 
+#if defined(CPUARM)
+int expoCubic(int x, int k)
+#else
 int expo(int x, int k)
+#endif
 {
   if (k == 0) return x;
   int y;
@@ -435,3 +483,64 @@ int expo(int x, int k)
   }
   return neg? -y : y;
 }
+
+#if defined(CPUARM)
+/*
+ * The expo curves between 0 and RESX, sampled every EXPO_TABLE_STEP and
+ * interpolated. A table only depends on its k value, it is never stale: a
+ * model load or an expo / GVar change only makes the mixer look for other k
+ * values. A table is built the second time its k value misses, so that a
+ * GVar which changes on each cycle doesn't rebuild tables all the time.
+ * Only the mixer task uses the tables, the menus (the expo graph) compute
+ * the curve: they would otherwise load a table under the mixer feet.
+ */
+ExpoTable expoTables[EXPO_TABLES];
+uint8_t expoTablesSlot[201];   // for each k value, its table index+1, 0 or EXPO_TABLE_MISSED
+uint8_t expoTablesNext;
+
+#define EXPO_TABLE_MISSED 0xff
+
+void expoTableLoad(int k)
+{
+  ExpoTable & table = expoTables[expoTablesNext];
+  if (table.k) {
+    expoTablesSlot[table.k+100] = 0;
+  }
+  for (int i=0; i<EXPO_TABLE_POINTS; i++) {
+    table.y[i] = expoCubic(i << EXPO_TABLE_SHIFT, k);
+  }
+  table.y[EXPO_TABLE_POINTS] = table.y[EXPO_TABLE_POINTS-1];
+  table.k = k;
+  expoTablesSlot[k+100] = expoTablesNext+1;
+  expoTablesNext = (expoTablesNext + 1) % EXPO_TABLES;
+}
+
+ExpoTable * expoTableGet(int k)
+{
+  uint8_t slot = expoTablesSlot[k+100];
+  if (slot == 0) {
+    expoTablesSlot[k+100] = EXPO_TABLE_MISSED;
+    return NULL;
+  }
+  if (slot == EXPO_TABLE_MISSED) {
+    expoTableLoad(k);
+    slot = expoTablesSlot[k+100];
+  }
+  return &expoTables[slot-1];
+}
+
+int expo(int x, int k)
+{
+  if (k == 0) return x;
+
+  unsigned int ux = (x < 0 ? -x : x);
+  ExpoTable * table;
+  if (ux > RESXu || CoGetCurTaskID() != mixerTaskId || !(table = expoTableGet(k)))
+    return expoCubic(x, k);
+
+  const int16_t * y = &table->y[ux >> EXPO_TABLE_SHIFT];
+  unsigned int dx = ux & (EXPO_TABLE_STEP-1);
+  int result = y[0] + (((unsigned int)(y[1] - y[0]) * dx + EXPO_TABLE_STEP/2) >> EXPO_TABLE_SHIFT);
+  return x < 0 ? -result : result;
+}
+#endif
@@ -47,6 +47,11 @@ void eeDirty(uint8_t msk)
 {
   s_eeDirtyMsk |= msk;
   s_eeDirtyTime10ms = get_tmr10ms() ;
+#if defined(CPUARM)
+  if (msk & EE_MODEL) {
+    modelChanged = true;
+  }
+#endif
 }
 
 uint8_t eeFindEmptyModel(uint8_t id, bool down)
@@ -358,6 +358,7 @@ void eeLoadModel(uint8_t id)
     AUDIO_FLUSH();
     flightReset();
     logicalSwitchesReset();
+    modelCachesInvalidate();
 
     if (pulsesStarted()) {
       checkAll();
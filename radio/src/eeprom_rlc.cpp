@@ -971,6 +971,9 @@ void eeLoadModel(uint8_t id)
     AUDIO_FLUSH();
     flightReset();
     logicalSwitchesReset();
+#if defined(CPUARM)
+    modelCachesInvalidate();
+#endif
 
     if (pulsesStarted()) {
 #if defined(GUI)
@@ -47,12 +47,14 @@ class Fifo
     {
     }
 
-    void push(uint8_t byte) {
+    bool push(uint8_t byte) {
       uint32_t next = (widx+1) & (N-1);
       if (next != ridx) {
         fifo[widx] = byte;
         widx = next;
+        return true;
       }
+      return false;
     }
 
     bool pop(uint8_t & byte) {
@@ -45,7 +45,10 @@ void menuModelTemplates(uint8_t event)
   if (sub < TMPL_COUNT) {
     if (s_warning_result) {
       s_warning_result = 0;
+      pauseMixerCalculations();
       applyTemplate(sub);
+      mixerPlanInvalidate();
+      resumeMixerCalculations();
       AUDIO_WARNING2();
     }
     if (event==EVT_KEY_BREAK(KEY_ENTER)) {
@@ -144,6 +144,7 @@ void deleteExpoMix(uint8_t expo, uint8_t idx)
     memmove(mix, mix+1, (MAX_MIXERS-(idx+1))*sizeof(MixData));
     memclear(&g_model.mixData[MAX_MIXERS-1], sizeof(MixData));
   }
+  mixerPlanInvalidate();
   resumeMixerCalculations();
   eeDirty(EE_MODEL);
 }
@@ -173,6 +174,7 @@ void insertExpoMix(uint8_t expo, uint8_t idx)
       mix->srcRaw = (s_currCh > 4 ? MIXSRC_Rud - 1 + s_currCh : MIXSRC_Rud - 1 + channel_order(s_currCh));
     mix->weight = 100;
   }
+  mixerPlanInvalidate();
   resumeMixerCalculations();
   eeDirty(EE_MODEL);
 }
@@ -188,6 +190,7 @@ void copyExpoMix(uint8_t expo, uint8_t idx)
     MixData *mix = mixAddress(idx);
     memmove(mix+1, mix, (MAX_MIXERS-(idx+1))*sizeof(MixData));
   }
+  mixerPlanInvalidate();
   resumeMixerCalculations();
   eeDirty(EE_MODEL);
 }
@@ -205,7 +208,7 @@ void memswap(void *a, void *b, uint8_t size)
   }
 }
 
-bool swapExpoMix(uint8_t expo, uint8_t &idx, uint8_t up)
+bool doSwapExpoMix(uint8_t expo, uint8_t &idx, uint8_t up)
 {
   void *x, *y;
   uint8_t size;
@@ -277,14 +280,22 @@ bool swapExpoMix(uint8_t expo, uint8_t &idx, uint8_t up)
     size = sizeof(MixData);
   }
 
-  pauseMixerCalculations();
   memswap(x, y, size);
-  resumeMixerCalculations();
 
   idx = tgt_idx;
   return true;
 }
 
+bool swapExpoMix(uint8_t expo, uint8_t &idx, uint8_t up)
+{
+  // the mixer is paused while the line changes place or channel, its plan is rebuilt before it runs again
+  pauseMixerCalculations();
+  bool result = doSwapExpoMix(expo, idx, up);
+  mixerPlanInvalidate();
+  resumeMixerCalculations();
+  return result;
+}
+
 enum ExposFields {
   EXPO_FIELD_INPUT_NAME,
   EXPO_FIELD_NAME,
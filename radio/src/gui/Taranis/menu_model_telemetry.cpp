@@ -244,6 +244,7 @@ void menuModelSensor(uint8_t event)
         sensor->type = selectMenuItem(SENSOR_2ND_COLUMN, y, NO_INDENT(STR_TYPE), STR_VSENSORTYPES, sensor->type, 0, 1, attr, event);
         if (attr && checkIncDec_Ret) {
           sensor->instance = 0;
+          telemetryRoutesInvalidate();
           if (sensor->type == TELEM_TYPE_CALCULATED) {
             sensor->param = 0;
             sensor->filter = 0;
@@ -267,6 +268,10 @@ void menuModelSensor(uint8_t event)
                 CHECK_INCDEC_MODELVAR_ZERO(event, sensor->instance, 0xff);
                 break;
             }
+            if (checkIncDec_Ret) {
+              // the values of the old id and instance must not reach this sensor any more
+              telemetryRoutesInvalidate();
+            }
           }
         }
         else {
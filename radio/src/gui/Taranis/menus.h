@@ -111,6 +111,11 @@ void menuModelSelect(uint8_t event);
 void menuModelCustomFunctions(uint8_t event);
 void menuStatisticsView(uint8_t event);
 void menuStatisticsDebug(uint8_t event);
+void menuStatisticsMixer(uint8_t event);
+void menuStatisticsTelemetry(uint8_t event);
+#if defined(LUA)
+void menuStatisticsLua(uint8_t event);
+#endif
 void menuAboutView(uint8_t event);
 #if defined(DEBUG_TRACE_BUFFER)
 void menuTraceBuffer(uint8_t event);
@@ -92,7 +92,7 @@ void menuStatisticsView(uint8_t event)
 #define MENU_DEBUG_Y_MIXMAX   (2*FH-3)
 #define MENU_DEBUG_Y_LUA      (3*FH-2)
 #define MENU_DEBUG_Y_FREE_RAM (4*FH-1)
-#define MENU_DEBUG_Y_STACK    (5*FH)
+#define MENU_DEBUG_Y_LATENCY  (5*FH)
 #define MENU_DEBUG_Y_RTOS     (6*FH)
 
 void menuStatisticsDebug(uint8_t event)
@@ -115,14 +115,20 @@ void menuStatisticsDebug(uint8_t event)
       maxLuaDuration = 0;
 #endif
       maxMixerDuration  = 0;
+      pulsesLatency.reset();
+#if defined(SDCARD)
+      wavUnderruns = 0;
+#endif
       AUDIO_KEYPAD_UP();
       break;
 
-#if defined(DEBUG_TRACE_BUFFER)
     case EVT_KEY_FIRST(KEY_UP):
-      pushMenu(menuTraceBuffer);
-      return;
+#if defined(LUA)
+      chainMenu(menuStatisticsLua);
+#else
+      chainMenu(menuStatisticsTelemetry);
 #endif
+      return;
 
     case EVT_KEY_FIRST(KEY_DOWN):
       chainMenu(menuStatisticsView);
@@ -135,6 +141,10 @@ void menuStatisticsDebug(uint8_t event)
   lcd_putsLeft(MENU_DEBUG_Y_FREE_RAM, "Free Mem");
   lcd_outdezAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_FREE_RAM, getAvailableMemory(), LEFT);
   lcd_puts(lcdLastPos, MENU_DEBUG_Y_FREE_RAM, "b");
+#if defined(SDCARD)
+  lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_FREE_RAM+1, "[WAV underruns]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_FREE_RAM, wavUnderruns, UNSIGN|LEFT);
+#endif
 
 #if defined(LUA)
   lcd_putsLeft(MENU_DEBUG_Y_LUA, "Lua scripts");
@@ -148,6 +158,18 @@ void menuStatisticsDebug(uint8_t event)
   lcd_outdezAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_MIXMAX, DURATION_MS_PREC2(maxMixerDuration), PREC2|LEFT);
   lcd_puts(lcdLastPos, MENU_DEBUG_Y_MIXMAX, "ms");
 
+  lcd_putsLeft(MENU_DEBUG_Y_LATENCY, "Latency");
+  LatencyStatistics latency = pulsesLatency.snapshot();
+  if (latency.count) {
+    lcd_putsAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_LATENCY+1, "[Min]", SMLSIZE);
+    lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_LATENCY, DURATION_MS_PREC2(latency.min), PREC2|LEFT);
+    lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_LATENCY+1, "[Avg]", SMLSIZE);
+    lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_LATENCY, DURATION_MS_PREC2(latency.avg()), PREC2|LEFT);
+    lcd_putsAtt(lcdLastPos+2, MENU_DEBUG_Y_LATENCY+1, "[Max]", SMLSIZE);
+    lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_LATENCY, DURATION_MS_PREC2(latency.max), PREC2|LEFT);
+    lcd_puts(lcdLastPos, MENU_DEBUG_Y_LATENCY, "ms");
+  }
+
   lcd_putsLeft(MENU_DEBUG_Y_RTOS, STR_FREESTACKMINB);
   lcd_putsAtt(MENU_DEBUG_COL1_OFS, MENU_DEBUG_Y_RTOS+1, "[M]", SMLSIZE);
   lcd_outdezAtt(lcdLastPos, MENU_DEBUG_Y_RTOS, stack_free(0), UNSIGN|LEFT);
@@ -162,6 +184,167 @@ void menuStatisticsDebug(uint8_t event)
   lcd_status_line();
 }
 
+#if defined(LUA)
+#define MENU_LUA_COL1_OFS     (11*FW-2)
+#define MENU_LUA_Y_GC         (2*FH-3)
+#define MENU_LUA_Y_HEAP       (3*FH-2)
+
+void menuStatisticsLua(uint8_t event)
+{
+  TITLE("LUA");
+
+  switch(event)
+  {
+    case EVT_KEY_FIRST(KEY_ENTER):
+      maxLuaGcDuration = 0;
+      AUDIO_KEYPAD_UP();
+      break;
+
+    case EVT_KEY_FIRST(KEY_UP):
+      chainMenu(menuStatisticsTelemetry);
+      return;
+
+    case EVT_KEY_FIRST(KEY_DOWN):
+      chainMenu(menuStatisticsDebug);
+      break;
+    case EVT_KEY_FIRST(KEY_EXIT):
+      chainMenu(menuMainView);
+      break;
+  }
+
+  lcd_putsLeft(MENU_LUA_Y_GC, "GC duration");
+  lcd_putsAtt(MENU_LUA_COL1_OFS, MENU_LUA_Y_GC+1, "[Max]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_LUA_Y_GC, maxLuaGcDuration/10, PREC2|LEFT);
+  lcd_puts(lcdLastPos, MENU_LUA_Y_GC, "ms");
+
+  lcd_putsLeft(MENU_LUA_Y_HEAP, "Heap");
+  lcd_putsAtt(MENU_LUA_COL1_OFS, MENU_LUA_Y_HEAP+1, "[After GC]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_LUA_Y_HEAP, luaHeapAfterGc, LEFT);
+  lcd_puts(lcdLastPos, MENU_LUA_Y_HEAP, "b");
+
+  lcd_puts(3*FW, 7*FH+1, STR_MENUTORESET);
+  lcd_status_line();
+}
+#endif
+
+#define MENU_MIXER_COL_MIN    (19*FW)
+#define MENU_MIXER_COL_AVG    (24*FW)
+#define MENU_MIXER_COL_MAX    (29*FW)
+#define MENU_MIXER_COL_HISTO  (30*FW)
+#define MENU_MIXER_LINE_H     7
+
+void menuStatisticsMixer(uint8_t event)
+{
+  TITLE("MIXER STAGES MIN/AVG/MAX (us)");
+
+  switch(event)
+  {
+    case EVT_KEY_FIRST(KEY_ENTER):
+      mixerStagesReset();
+      AUDIO_KEYPAD_UP();
+      break;
+
+#if defined(DEBUG_TRACE_BUFFER)
+    case EVT_KEY_FIRST(KEY_UP):
+      pushMenu(menuTraceBuffer);
+      return;
+#endif
+
+    case EVT_KEY_FIRST(KEY_DOWN):
+      chainMenu(menuStatisticsTelemetry);
+      break;
+    case EVT_KEY_FIRST(KEY_EXIT):
+      chainMenu(menuMainView);
+      break;
+  }
+
+  for (uint8_t i=0; i<MIXER_STAGES_COUNT; i++) {
+    const MixerStageStatistics & stage = mixerStages[i];
+    coord_t y = FH + 1 + i*MENU_MIXER_LINE_H;
+    lcd_putsAtt(0, y, mixerStagesNames[i], SMLSIZE);
+    if (stage.count) {
+      lcd_outdezAtt(MENU_MIXER_COL_MIN, y, stage.min, SMLSIZE);
+      lcd_outdezAtt(MENU_MIXER_COL_AVG, y, stage.avg(), SMLSIZE);
+      lcd_outdezAtt(MENU_MIXER_COL_MAX, y, stage.max, SMLSIZE);
+      // the histogram bars are scaled to the highest bin
+      uint16_t highest = 0;
+      for (uint8_t j=0; j<MIXER_STAGE_HISTOGRAM_BINS; j++) {
+        if (stage.histogram[j] > highest) highest = stage.histogram[j];
+      }
+      for (uint8_t j=0; j<MIXER_STAGE_HISTOGRAM_BINS; j++) {
+        scoord_t h = (stage.histogram[j] * (MENU_MIXER_LINE_H-1) + highest - 1) / highest;
+        coord_t x = MENU_MIXER_COL_HISTO + j*4;
+        lcd_vline(x, y+MENU_MIXER_LINE_H-1-h, h);
+        lcd_vline(x+1, y+MENU_MIXER_LINE_H-1-h, h);
+        lcd_vline(x+2, y+MENU_MIXER_LINE_H-1-h, h);
+      }
+    }
+  }
+}
+
+#define MENU_TELEMETRY_COL1_OFS   (11*FW-2)
+#define MENU_TELEMETRY_Y_BYTES    (2*FH-3)
+#define MENU_TELEMETRY_Y_FRAMES   (3*FH-2)
+#define MENU_TELEMETRY_Y_ERRORS   (4*FH-1)
+#define MENU_TELEMETRY_Y_RAW      (5*FH)
+#define MENU_TELEMETRY_Y_PARSE    (6*FH)
+
+void menuStatisticsTelemetry(uint8_t event)
+{
+  TITLE("TELEMETRY LINK");
+
+  switch(event)
+  {
+    case EVT_KEY_FIRST(KEY_ENTER):
+      telemetryStats.reset();
+      AUDIO_KEYPAD_UP();
+      break;
+
+    case EVT_KEY_FIRST(KEY_UP):
+      chainMenu(menuStatisticsMixer);
+      return;
+
+    case EVT_KEY_FIRST(KEY_DOWN):
+#if defined(LUA)
+      chainMenu(menuStatisticsLua);
+#else
+      chainMenu(menuStatisticsDebug);
+#endif
+      break;
+    case EVT_KEY_FIRST(KEY_EXIT):
+      chainMenu(menuMainView);
+      break;
+  }
+
+  lcd_putsLeft(MENU_TELEMETRY_Y_BYTES, "Bytes");
+  lcd_outdezAtt(MENU_TELEMETRY_COL1_OFS, MENU_TELEMETRY_Y_BYTES, telemetryStats.bytes, UNSIGN|LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_TELEMETRY_Y_BYTES+1, "[UART errors]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_TELEMETRY_Y_BYTES, telemetryStats.uartErrors, UNSIGN|LEFT);
+
+  lcd_putsLeft(MENU_TELEMETRY_Y_FRAMES, "Frames");
+  lcd_outdezAtt(MENU_TELEMETRY_COL1_OFS, MENU_TELEMETRY_Y_FRAMES, telemetryStats.frames, UNSIGN|LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_TELEMETRY_Y_FRAMES+1, "[Dropped]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_TELEMETRY_Y_FRAMES, telemetryStats.droppedFrames, UNSIGN|LEFT);
+
+  lcd_putsLeft(MENU_TELEMETRY_Y_ERRORS, "Errors");
+  lcd_putsAtt(MENU_TELEMETRY_COL1_OFS, MENU_TELEMETRY_Y_ERRORS+1, "[Frames]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_TELEMETRY_Y_ERRORS, telemetryStats.badFrames, UNSIGN|LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_TELEMETRY_Y_ERRORS+1, "[CRC]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_TELEMETRY_Y_ERRORS, telemetryStats.crcErrors, UNSIGN|LEFT);
+
+  lcd_putsLeft(MENU_TELEMETRY_Y_RAW, "Raw dropped");
+  lcd_outdezAtt(MENU_TELEMETRY_COL1_OFS, MENU_TELEMETRY_Y_RAW, telemetryStats.rawDropped, UNSIGN|LEFT);
+
+  lcd_putsLeft(MENU_TELEMETRY_Y_PARSE, "Parse time");
+  lcd_putsAtt(MENU_TELEMETRY_COL1_OFS, MENU_TELEMETRY_Y_PARSE+1, "[Last]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_TELEMETRY_Y_PARSE, telemetryStats.parseLast, UNSIGN|LEFT);
+  lcd_putsAtt(lcdLastPos+2, MENU_TELEMETRY_Y_PARSE+1, "[Max]", SMLSIZE);
+  lcd_outdezAtt(lcdLastPos, MENU_TELEMETRY_Y_PARSE, telemetryStats.parseMax, UNSIGN|LEFT);
+  lcd_puts(lcdLastPos, MENU_TELEMETRY_Y_PARSE, "us");
+
+  lcd_puts(3*FW, 7*FH+1, STR_MENUTORESET);
+  lcd_status_line();
+}
 
 #if defined(DEBUG_TRACE_BUFFER)
 #include "stamp-opentx.h"
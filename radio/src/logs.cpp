@@ -49,6 +49,137 @@ uint8_t logDelay;
 
 #define get3PosState(sw) (switchState(SW_ ## sw ## 0) ? -1 : (switchState(SW_ ## sw ## 2) ? 1 : 0))
 
+#if defined(PCBTARANIS)
+  #define LOGS_STICKS_LABELS    "Rud,Ele,Thr,Ail,S1,S2,S3,LS,RS,"
+  #define LOGS_SWITCHES_LABELS  "SA,SB,SC,SD,SE,SF,SG,SH"
+#else
+  #define LOGS_STICKS_LABELS    "Rud,Ele,Thr,Ail,P1,P2,P3,"
+  #define LOGS_SWITCHES_LABELS  "THR,RUD,ELE,3POS,AIL,GEA,TRN"
+#endif
+
+#if defined(BINARY_LOGS)
+// The binary logs: each session starts with a header which gives the CSV columns, then come samples of a
+// fixed size with the differences of the values since the previous sample, or with the values themselves
+// (keyframes) at the start, regularly, and when a difference doesn't fit in 16 bits. The samples are
+// taken in the mixer task and buffered in RAM, the menus task writes them by whole sectors. Their period
+// is the one of the models, in 0.1s, so they are at most 10Hz like the CSV logs.
+// util/logs2csv.py converts them to the CSV layout. All the numbers are little endian:
+//   header    LogsHeader, then for each field: type, prec, CSV column(s) zero terminated
+//   keyframe  'K', tmr10ms (4 bytes), the values (4 bytes each)
+//   delta     'D', the 10ms elapsed since the previous sample (1 byte), the differences (2 bytes each)
+#define LOGS_MAGIC              "OTXL"
+#define LOGS_VERSION            1
+#define LOGS_RECORD_KEYFRAME    'K'
+#define LOGS_RECORD_DELTA       'D'
+#define LOGS_KEYFRAME_PERIOD    100     // samples
+#define LOGS_FIELD_VALUE        0
+#define LOGS_FIELD_SWITCHES     1       // the states of the switches + 1, 2 bits each
+#define LOGS_MAX_FIELDS         (MAX_SENSORS+NUM_STICKS+NUM_POTS+1)
+#define LOGS_SECTOR_SIZE        512
+#if defined(SIMU)
+  #define LOGS_BUFFER_SIZE      8192
+#else
+  // 1s of 10Hz logs with 32 sensors, a SD write may take 250ms
+  #define LOGS_BUFFER_SIZE      2048
+#endif
+
+PACK(struct LogsHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t fieldsCount;
+  uint16_t period;      // 10ms
+  uint32_t tmr10ms;     // when the date and time were read
+  uint8_t rtc;          // the date and time are valid
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t min;
+  uint8_t sec;
+  uint8_t ms10;
+});
+
+uint8_t logsBuffer[LOGS_BUFFER_SIZE];
+volatile uint32_t logsBufferHead = 0;   // moved by the samples
+volatile uint32_t logsBufferTail = 0;   // moved by the SD writes
+volatile bool logsRecording = false;
+uint16_t logsOverruns = 0;              // the samples lost because the buffer was full
+
+uint8_t logsSensors[MAX_SENSORS];
+uint8_t logsSensorsCount;
+uint8_t logsFieldsCount;
+uint8_t logsSamplesToKeyframe;
+int32_t logsLastValues[LOGS_MAX_FIELDS];
+
+static bool logsBufferPush(const void * data, uint32_t size)
+{
+  uint32_t head = logsBufferHead;
+  if (LOGS_BUFFER_SIZE - (head - logsBufferTail) < size) {
+    return false;
+  }
+  uint32_t index = head & (LOGS_BUFFER_SIZE-1);
+  uint32_t len = min<uint32_t>(size, LOGS_BUFFER_SIZE-index);
+  memcpy(&logsBuffer[index], data, len);
+  memcpy(logsBuffer, (const uint8_t *)data + len, size - len);
+  logsBufferHead = head + size;
+  return true;
+}
+
+// Writes the whole sectors of the buffer, or all of it
+static FRESULT flushLogs(bool all)
+{
+  while (1) {
+    uint32_t tail = logsBufferTail;
+    uint32_t count = logsBufferHead - tail;
+    uint32_t index = tail & (LOGS_BUFFER_SIZE-1);
+    // the buffer has the alignment of the file (see writeHeader()), its end is the end of a sector
+    uint32_t size = LOGS_SECTOR_SIZE - (index & (LOGS_SECTOR_SIZE-1));
+    uint32_t contiguous = min<uint32_t>(count, LOGS_BUFFER_SIZE-index);
+    if (contiguous >= size) {
+      size += (contiguous - size) & ~(LOGS_SECTOR_SIZE-1);
+    }
+    else if (all && count > 0) {
+      size = contiguous;
+    }
+    else {
+      return FR_OK;
+    }
+    UINT written;
+    FRESULT result = f_write(&g_oLogFile, &logsBuffer[index], size, &written);
+    if (result != FR_OK) {
+      return result;
+    }
+    if (written != size) {
+      // the SD card is full
+      return FR_DENIED;
+    }
+    logsBufferTail = tail + size;
+  }
+}
+
+static void logsPushField(uint8_t type, uint8_t prec, const char * label, int len)
+{
+  uint8_t field[2] = { type, prec };
+  logsBufferPush(field, sizeof(field));
+  logsBufferPush(label, len);
+  logsBufferPush("", 1);
+}
+
+static int32_t logsSwitchesStates()
+{
+#if defined(PCBTARANIS)
+  int8_t states[] = { get3PosState(SA), get3PosState(SB), get3PosState(SC), get3PosState(SD), get3PosState(SE), get2PosState(SF), get3PosState(SG), get2PosState(SH) };
+#else
+  int8_t states[] = { get2PosState(THR), get2PosState(RUD), get2PosState(ELE), get3PosState(ID), get2PosState(AIL), get2PosState(GEA), get2PosState(TRN) };
+#endif
+  int32_t result = 0;
+  for (unsigned int i=0; i<DIM(states); i++) {
+    result |= (states[i] + 1) << (2*i);
+  }
+  return result;
+}
+#endif
+
 const pm_char *openLogs()
 {
   // Determine and set log file filename
@@ -111,6 +242,14 @@ const pm_char *openLogs()
     return SDCARD_ERROR(result);
   }
 
+#if defined(BINARY_LOGS)
+  // each session has its header, the sensors may have changed
+  result = f_lseek(&g_oLogFile, f_size(&g_oLogFile));
+  if (result != FR_OK) {
+    return SDCARD_ERROR(result);
+  }
+  writeHeader();
+#else
   if (f_size(&g_oLogFile) == 0) {
     writeHeader();
   }
@@ -120,6 +259,7 @@ const pm_char *openLogs()
       return SDCARD_ERROR(result);
     }
   }
+#endif
 
   return NULL;
 }
@@ -128,6 +268,12 @@ tmr10ms_t lastLogTime = 0;
 
 void closeLogs()
 {
+#if defined(BINARY_LOGS)
+  logsRecording = false;
+  if (g_oLogFile.fs) {
+    flushLogs(true);
+  }
+#endif
   if (f_close(&g_oLogFile) != FR_OK) {
     // close failed, forget file
     g_oLogFile.fs = 0;
@@ -143,6 +289,164 @@ getvalue_t getConvertedTelemetryValue(getvalue_t val, uint8_t unit)
 }
 #endif
 
+#if defined(BINARY_LOGS)
+void writeHeader()
+{
+  // the buffer gets the alignment of the end of the file, so that the sectors are written at once
+  logsBufferHead = logsBufferTail = f_tell(&g_oLogFile);
+
+  logsSensorsCount = 0;
+#if defined(FRSKY)
+  // the same sensors as the CSV logs
+  for (int i=0; i<MAX_SENSORS; i++) {
+    if (g_model.telemetrySensors[i].logs) {
+      logsSensors[logsSensorsCount++] = i;
+    }
+  }
+#endif
+  logsFieldsCount = logsSensorsCount + NUM_STICKS + NUM_POTS + 1;
+
+  LogsHeader header;
+  memclear(&header, sizeof(header));
+  memcpy(header.magic, LOGS_MAGIC, sizeof(header.magic));
+  header.version = LOGS_VERSION;
+  header.fieldsCount = logsFieldsCount;
+  header.period = logDelay * 10;
+  header.tmr10ms = get_tmr10ms();
+#if defined(RTCLOCK)
+  struct gtm utm;
+  gettime(&utm);
+  header.rtc = 1;
+  header.year = utm.tm_year + 1900;
+  header.month = utm.tm_mon + 1;
+  header.day = utm.tm_mday;
+  header.hour = utm.tm_hour;
+  header.min = utm.tm_min;
+  header.sec = utm.tm_sec;
+  header.ms10 = g_ms100;
+#endif
+  logsBufferPush(&header, sizeof(header));
+
+  char label[TELEM_LABEL_LEN+7];
+  for (int i=0; i<logsSensorsCount; i++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[logsSensors[i]];
+    memset(label, 0, sizeof(label));
+    zchar2str(label, sensor.label, TELEM_LABEL_LEN);
+    if (sensor.unit != UNIT_RAW) {
+      strcat(label, "(");
+      strncat(label, STR_VTELEMUNIT+1+3*sensor.unit, 3);
+      strcat(label, ")");
+    }
+    logsPushField(LOGS_FIELD_VALUE, sensor.prec, label, strlen(label));
+  }
+
+  const char * sticks = LOGS_STICKS_LABELS;
+  for (int i=0; i<NUM_STICKS+NUM_POTS; i++) {
+    const char * end = strchr(sticks, ',');
+    int len = (end ? end - sticks : strlen(sticks));
+    logsPushField(LOGS_FIELD_VALUE, 0, sticks, len);
+    sticks += (end ? len + 1 : len);
+  }
+
+  logsPushField(LOGS_FIELD_SWITCHES, 0, LOGS_SWITCHES_LABELS, sizeof(LOGS_SWITCHES_LABELS)-1);
+
+  logsSamplesToKeyframe = 0;
+  lastLogTime = 0;
+  logsRecording = true;
+}
+
+// Called from the mixer task, each 10ms
+void sampleLogs()
+{
+  if (!logsRecording) {
+    return;
+  }
+
+  tmr10ms_t tmr10ms = get_tmr10ms();
+  tmr10ms_t elapsed = tmr10ms - lastLogTime;
+  if (lastLogTime != 0 && elapsed < (tmr10ms_t)logDelay*10) {
+    return;
+  }
+  lastLogTime = tmr10ms;
+
+  // not on the stack, the mixer one is small
+  static int32_t values[LOGS_MAX_FIELDS];
+  static uint8_t record[1+sizeof(uint32_t)+LOGS_MAX_FIELDS*sizeof(int32_t)];
+
+  int count = 0;
+  for (int i=0; i<logsSensorsCount; i++) {
+    values[count++] = telemetryItems[logsSensors[i]].value;
+  }
+  for (int i=0; i<NUM_STICKS+NUM_POTS; i++) {
+    values[count++] = calibratedStick[i];
+  }
+  values[count++] = logsSwitchesStates();
+
+  bool keyframe = (logsSamplesToKeyframe == 0 || elapsed > 255);
+  uint8_t * data = &record[2];
+  if (!keyframe) {
+    record[0] = LOGS_RECORD_DELTA;
+    record[1] = elapsed;
+    for (int i=0; i<count; i++) {
+      int32_t delta = values[i] - logsLastValues[i];
+      if (delta < -32768 || delta > 32767) {
+        keyframe = true;
+        break;
+      }
+      int16_t value = delta;
+      memcpy(data, &value, sizeof(value));
+      data += sizeof(value);
+    }
+  }
+  if (keyframe) {
+    record[0] = LOGS_RECORD_KEYFRAME;
+    uint32_t time = tmr10ms;
+    memcpy(&record[1], &time, sizeof(time));
+    memcpy(&record[5], values, count*sizeof(int32_t));
+    data = &record[5] + count*sizeof(int32_t);
+  }
+
+  if (logsBufferPush(record, data - record)) {
+    memcpy(logsLastValues, values, count*sizeof(int32_t));
+    logsSamplesToKeyframe = (keyframe ? LOGS_KEYFRAME_PERIOD : logsSamplesToKeyframe) - 1;
+  }
+  else {
+    // the next differences would be from a lost sample
+    logsOverruns++;
+    logsSamplesToKeyframe = 0;
+  }
+}
+
+void writeLogs()
+{
+  static const pm_char * error_displayed = NULL;
+
+  if (isFunctionActive(FUNCTION_LOGS) && logDelay > 0) {
+    if (!g_oLogFile.fs) {
+      const pm_char * result = openLogs();
+      if (result != NULL) {
+        if (result != error_displayed) {
+          error_displayed = result;
+          POPUP_WARNING(result);
+        }
+        return;
+      }
+    }
+
+    if (flushLogs(false) != FR_OK && !error_displayed) {
+      error_displayed = STR_SDCARD_ERROR;
+      POPUP_WARNING(STR_SDCARD_ERROR);
+      closeLogs();
+    }
+  }
+  else {
+    error_displayed = NULL;
+    if (g_oLogFile.fs) {
+      closeLogs();
+    }
+  }
+}
+#else
 void writeHeader()
 {
 #if defined(RTCLOCK)
@@ -187,11 +491,7 @@ void writeHeader()
 #endif
 #endif
 
-#if defined(PCBTARANIS)
-  f_puts("Rud,Ele,Thr,Ail,S1,S2,S3,LS,RS,SA,SB,SC,SD,SE,SF,SG,SH\n", &g_oLogFile);
-#else
-  f_puts("Rud,Ele,Thr,Ail,P1,P2,P3,THR,RUD,ELE,3POS,AIL,GEA,TRN\n", &g_oLogFile);
-#endif
+  f_puts(LOGS_STICKS_LABELS LOGS_SWITCHES_LABELS "\n", &g_oLogFile);
 }
 
 void writeLogs()
@@ -344,6 +644,7 @@ void writeLogs()
     }
   }
 }
+#endif
 
 
 
@@ -39,6 +39,7 @@
 #include "opentx.h"
 #include "stamp-opentx.h"
 #include "bin_allocator.h"
+#include "pool_allocator.h"
 #include "timers.h"
 
 #if !defined(SIMU)
@@ -73,12 +74,20 @@ ScriptInputsOutputs scriptInputsOutputs[MAX_SCRIPTS] = { {0} };
 ScriptInternalData standaloneScript = { SCRIPT_NOFILE, 0 };
 uint16_t maxLuaInterval = 0;
 uint16_t maxLuaDuration = 0;
+uint16_t maxLuaGcDuration = 0; // us
+int luaHeapAfterGc = 0;        // the Lua memory used after the last completed collection cycle
 bool luaLcdAllowed;
 
 #define PERMANENT_SCRIPTS_MAX_INSTRUCTIONS (10000/100)
 #define MANUAL_SCRIPTS_MAX_INSTRUCTIONS    (20000/100)
 #define SET_LUA_INSTRUCTIONS_COUNT(x)      (instructionsPercent=0, lua_sethook(L, hook, LUA_MASKCOUNT, x))
 
+#define LUA_GC_BUDGET_MIN                  200                // us of incremental collection after each luaTask() ...
+#define LUA_GC_BUDGET_MAX                  2000               // ... growing with the heap up to the full collection threshold
+#if defined(SIMU)
+  #define LUA_SIMU_MEM_MAX                 (64*1024)          // the simulator heap has no limit, it gets half of the 128kB RAM of a Taranis
+#endif
+
 struct our_longjmp * global_lj = 0;
 
 /* custom panic handler */
@@ -161,24 +170,75 @@ struct LuaField {
 
 #define FIND_FIELD_DESC  0x01
 
+struct LuaSensorName {
+  uint8_t len;
+  char name[TELEM_LABEL_LEN+1];
+};
+
+// The sensor labels converted from zchar once, reloaded after model changes
+LuaSensorName luaSensorNames[MAX_SENSORS];
+bool luaSensorNamesValid = false;
+
+void luaSensorNamesLoad()
+{
+  for (int i=0; i<MAX_SENSORS; i++) {
+    LuaSensorName & sensorName = luaSensorNames[i];
+    if (isTelemetryFieldAvailable(i))
+      sensorName.len = zchar2str(sensorName.name, g_model.telemetrySensors[i].label, TELEM_LABEL_LEN);
+    else
+      sensorName.len = 0;
+  }
+  luaSensorNamesValid = true;
+}
+
+int luaFindSensorName(const char * name, unsigned int len)
+{
+  for (int i=0; i<MAX_SENSORS; i++) {
+    const LuaSensorName & sensorName = luaSensorNames[i];
+    if (sensorName.len == len && !memcmp(sensorName.name, name, len)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+  Return the index of a field name in luaSingleFields[], -1 if not found
+  (the array is generated sorted by name by luaexport.py)
+*/
+int luaFindSingleField(const char * name)
+{
+  int first = 0;
+  int last = DIM(luaSingleFields) - 1;
+  while (first <= last) {
+    int n = (first + last) / 2;
+    int result = strcmp(name, luaSingleFields[n].name);
+    if (result == 0)
+      return n;
+    else if (result < 0)
+      last = n - 1;
+    else
+      first = n + 1;
+  }
+  return -1;
+}
+
 /**
   Return field data for a given field name
 */
 bool luaFindFieldByName(const char * name, LuaField & field, unsigned int flags=0)
 {
-  // TODO better search method (binary lookup)
-  for (unsigned int n=0; n<DIM(luaSingleFields); ++n) {
-    if (!strcmp(name, luaSingleFields[n].name)) {
-      field.id = luaSingleFields[n].id;
-      if (flags & FIND_FIELD_DESC) {
-        strncpy(field.desc, luaSingleFields[n].desc, sizeof(field.desc)-1);
-        field.desc[sizeof(field.desc)-1] = '\0';
-      }
-      else {
-        field.desc[0] = '\0';
-      }
-      return true;
+  int n = luaFindSingleField(name);
+  if (n >= 0) {
+    field.id = luaSingleFields[n].id;
+    if (flags & FIND_FIELD_DESC) {
+      strncpy(field.desc, luaSingleFields[n].desc, sizeof(field.desc)-1);
+      field.desc[sizeof(field.desc)-1] = '\0';
+    }
+    else {
+      field.desc[0] = '\0';
     }
+    return true;
   }
 
   // search in multiples
@@ -211,29 +271,24 @@ bool luaFindFieldByName(const char * name, LuaField & field, unsigned int flags=
     }
   }
 
-  // search in telemetry
+  // search in telemetry, "name-" is the min value and "name+" the max value
   field.desc[0] = '\0';
-  for (int i=0; i<MAX_SENSORS; i++) {
-    if (isTelemetryFieldAvailable(i)) {
-      char sensorName[TELEM_LABEL_LEN+1];
-      int len = zchar2str(sensorName, g_model.telemetrySensors[i].label, TELEM_LABEL_LEN);
-      if (!strncmp(sensorName, name, len)) {
-        if (name[len] == '\0') {
-          field.id = MIXSRC_FIRST_TELEM + 3*i;
-          field.desc[0] = '\0';
-          return true;
-        }
-        else if (name[len] == '-' && name[len+1] == '\0') {
-          field.id = MIXSRC_FIRST_TELEM + 3*i + 1;
-          field.desc[0] = '\0';
-          return true;
-        }
-        else if (name[len] == '+' && name[len+1] == '\0') {
-          field.id = MIXSRC_FIRST_TELEM + 3*i + 2;
-          field.desc[0] = '\0';
-          return true;
-        }
-      }
+  if (len > TELEM_LABEL_LEN+1) {
+    return false;
+  }
+  if (!luaSensorNamesValid) {
+    luaSensorNamesLoad();
+  }
+  int index = luaFindSensorName(name, len);
+  if (index >= 0) {
+    field.id = MIXSRC_FIRST_TELEM + 3*index;
+    return true;
+  }
+  if (len > 1 && (name[len-1] == '-' || name[len-1] == '+')) {
+    index = luaFindSensorName(name, len-1);
+    if (index >= 0) {
+      field.id = MIXSRC_FIRST_TELEM + 3*index + (name[len-1] == '-' ? 1 : 2);
+      return true;
     }
   }
 
@@ -256,22 +311,66 @@ static int luaGetFieldInfo(lua_State *L)
   return 0;
 }
 
-static int luaGetValue(lua_State *L)
+// the source id of a name or of an id, 0 if the name is unknown
+static int luaGetSourceId(lua_State *L, int index)
 {
-  int src = 0;
-  if (lua_isnumber(L, 1)) {
-    src = luaL_checkinteger(L, 1);
+  if (lua_isnumber(L, index)) {
+    return luaL_checkinteger(L, index);
   }
   else {
     // convert from field name to its id
-    const char *name = luaL_checkstring(L, 1);
+    const char *name = luaL_checkstring(L, index);
     LuaField field;
     bool found = luaFindFieldByName(name, field);
-    if (found) {
-      src = field.id;
-    }
+    return found ? field.id : 0;
+  }
+}
+
+// getValue(id) skips the name lookup, scripts may resolve the id once with getFieldInfo(name).id
+static int luaGetValue(lua_State *L)
+{
+  luaGetValueAndPush(luaGetSourceId(L, 1));
+  return 1;
+}
+
+#define LUA_VALUES_HANDLE  "opentx.values"
+
+struct LuaValuesHandle {
+  uint16_t count;
+  uint16_t ids[1];
+};
+
+// registerValues({name or id, ...}) returns a handle on the sources, for getValues()
+static int luaRegisterValues(lua_State *L)
+{
+  luaL_checktype(L, 1, LUA_TTABLE);
+  int count = luaL_len(L, 1);
+  LuaValuesHandle * handle = (LuaValuesHandle *)lua_newuserdata(L, sizeof(LuaValuesHandle) + count*sizeof(uint16_t));
+  handle->count = count;
+  for (int i=0; i<count; i++) {
+    lua_rawgeti(L, 1, i+1);
+    handle->ids[i] = luaGetSourceId(L, -1);
+    lua_pop(L, 1);
+  }
+  luaL_setmetatable(L, LUA_VALUES_HANDLE);
+  return 1;
+}
+
+// getValues(handle [, table]) fills the table (a new one if not given) with the values of the sources,
+// in the order they were registered, the same way getValue() returns them
+static int luaGetValues(lua_State *L)
+{
+  const LuaValuesHandle * handle = (const LuaValuesHandle *)luaL_checkudata(L, 1, LUA_VALUES_HANDLE);
+  if (lua_istable(L, 2)) {
+    lua_settop(L, 2);
+  }
+  else {
+    lua_createtable(L, handle->count, 0);
+  }
+  for (int i=0; i<handle->count; i++) {
+    luaGetValueAndPush(handle->ids[i]);
+    lua_rawseti(L, -2, i+1);
   }
-  luaGetValueAndPush(src);
   return 1;
 }
 
@@ -343,6 +442,29 @@ static int luaGetGeneralSettings(lua_State *L)
   return 1;
 }
 
+static int luaGetMixerStatistics(lua_State *L)
+{
+  lua_newtable(L);
+  for (uint8_t i=0; i<MIXER_STAGES_COUNT; i++) {
+    const MixerStageStatistics & stage = mixerStages[i];
+    lua_pushstring(L, mixerStagesNames[i]);
+    lua_newtable(L);
+    lua_pushtableinteger(L, "count", stage.count);
+    lua_pushtableinteger(L, "min", stage.min);
+    lua_pushtableinteger(L, "avg", stage.avg());
+    lua_pushtableinteger(L, "max", stage.max);
+    lua_pushstring(L, "histogram");
+    lua_newtable(L);
+    for (uint8_t j=0; j<MIXER_STAGE_HISTOGRAM_BINS; j++) {
+      lua_pushinteger(L, stage.histogram[j]);
+      lua_rawseti(L, -2, j+1);
+    }
+    lua_settable(L, -3);
+    lua_settable(L, -3);
+  }
+  return 1;
+}
+
 static int luaLcdLock(lua_State *L)
 {
   // disabled in opentx 2.1
@@ -988,7 +1110,10 @@ static int luaModelDeleteMix(lua_State *L)
 
 static int luaModelDeleteMixes(lua_State *L)
 {
+  pauseMixerCalculations();
   memset(g_model.mixData, 0, sizeof(g_model.mixData));
+  mixerPlanInvalidate();
+  resumeMixerCalculations();
   return 0;
 }
 
@@ -1366,7 +1491,10 @@ const luaL_Reg opentxLib[] = {
   { "getDateTime", luaGetDateTime },
   { "getVersion", luaGetVersion },
   { "getGeneralSettings", luaGetGeneralSettings },
+  { "getMixerStatistics", luaGetMixerStatistics },
   { "getValue", luaGetValue },
+  { "registerValues", luaRegisterValues },
+  { "getValues", luaGetValues },
   { "getFieldInfo", luaGetFieldInfo },
   { "playFile", luaPlayFile },
   { "playNumber", luaPlayNumber },
@@ -1515,13 +1643,19 @@ void luaRegisterAll()
 {
   // Init lua
   luaL_openlibs(L);
+
+  // the metatable of the getValues() handles
+  luaL_newmetatable(L, LUA_VALUES_HANDLE);
+  lua_pop(L, 1);
 }
 
 void luaInit()
 {
   luaClose();
   if (luaState != INTERPRETER_PANIC) {
-#if defined(USE_BIN_ALLOCATOR)
+#if defined(USE_POOL_ALLOCATOR)
+    L = lua_newstate(pool_l_alloc, NULL);   //we use our own allocator!
+#elif defined(USE_BIN_ALLOCATOR)
     L = lua_newstate(bin_l_alloc, NULL);   //we use our own allocator!
 #else
     L = lua_newstate(l_alloc, NULL);   //we use Lua default allocator
@@ -1567,6 +1701,118 @@ void luaFree(ScriptInternalData & sid)
   UNPROTECT_LUA();
 }
 
+static int luaDumpWriter(lua_State * L, const void * data, size_t size, void * file)
+{
+  UINT written;
+  FRESULT result = f_write((FIL *)file, data, size, &written);
+  return (result != FR_OK || written != size);
+}
+
+// The .luac files start with the date, time and size of the source they were compiled from
+#define SCRIPTS_BYTECODE_MAGIC "OTXC"
+
+PACK(struct ScriptBytecodeHeader {
+  char magic[4];
+  uint16_t fdate;
+  uint16_t ftime;
+  uint32_t fsize;
+});
+
+struct ScriptBytecodeFile {
+  FIL file;
+  char buffer[LUAL_BUFFERSIZE];
+};
+
+// Shared by the bytecode reads and writes, it is too big for the menus stack
+static ScriptBytecodeFile scriptBytecodeFile;
+
+static const char * luaBytecodeReader(lua_State * L, void * ud, size_t * size)
+{
+  ScriptBytecodeFile * reader = (ScriptBytecodeFile *)ud;
+  UINT count;
+  if (f_read(&reader->file, reader->buffer, sizeof(reader->buffer), &count) != FR_OK || count == 0) {
+    return NULL;
+  }
+  *size = count;
+  return reader->buffer;
+}
+
+static int luaLoadBytecodeFile(const char * filename, const ScriptBytecodeHeader & source, const char * chunkname)
+{
+  ScriptBytecodeFile & reader = scriptBytecodeFile;
+  if (f_open(&reader.file, filename, FA_OPEN_EXISTING | FA_READ) != FR_OK) {
+    return -1;
+  }
+  int result = -1;
+  ScriptBytecodeHeader header;
+  UINT count;
+  if (f_read(&reader.file, &header, sizeof(header), &count) == FR_OK && count == sizeof(header) && !memcmp(&header, &source, sizeof(header))) {
+    result = lua_load(L, luaBytecodeReader, &reader, chunkname, "b");
+    if (result != 0) {
+      TRACE("Lua bytecode %s rejected: %s", filename, lua_tostring(L, -1));
+      lua_pop(L, 1);
+    }
+  }
+  f_close(&reader.file);
+  return result;
+}
+
+// The script is loaded from its bytecode (the .luac file next to it) when the bytecode was compiled
+// from a source with the same date, time and size. The FAT dates can't tell which file is newer
+// (2s precision, clock of the computer which wrote the file). Else the source is compiled, and its
+// bytecode written for the next time. A bytecode written by a different Lua build is rejected by
+// lua_load(), the source is then used.
+int luaLoadScriptFile(const char * filename)
+{
+  char bytecode[_MAX_LFN+1];
+  int len = strlen(filename) - (sizeof(SCRIPTS_EXT)-1);
+  if (len <= 0 || len+sizeof(SCRIPTS_BYTECODE_EXT) > sizeof(bytecode) || strcasecmp(filename+len, SCRIPTS_EXT)) {
+    return luaL_loadfile(L, filename);
+  }
+
+  FILINFO info;
+  info.lfname = NULL;
+  info.lfsize = 0;
+  if (f_stat(filename, &info) != FR_OK) {
+    // no bytecode without its source
+    return luaL_loadfile(L, filename);
+  }
+
+  ScriptBytecodeHeader header;
+  memcpy(header.magic, SCRIPTS_BYTECODE_MAGIC, sizeof(header.magic));
+  header.fdate = info.fdate;
+  header.ftime = info.ftime;
+  header.fsize = info.fsize;
+
+  memcpy(bytecode, filename, len);
+  strcpy(bytecode+len, SCRIPTS_BYTECODE_EXT);
+
+  lua_pushfstring(L, "@%s", filename);
+  int result = luaLoadBytecodeFile(bytecode, header, lua_tostring(L, -1));
+  lua_remove(L, result == 0 ? -2 : -1);
+  if (result == 0) {
+    return 0;
+  }
+
+  // a precompiled .lua is accepted, as before the .luac files
+  result = luaL_loadfile(L, filename);
+  if (result == 0) {
+    FIL & file = scriptBytecodeFile.file;
+    if (f_open(&file, bytecode, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK) {
+      UINT written;
+      bool error = (f_write(&file, &header, sizeof(header), &written) != FR_OK || written != sizeof(header));
+      if (!error) {
+        error = lua_dump(L, luaDumpWriter, &file);
+      }
+      f_close(&file);
+      if (error) {
+        f_unlink(bytecode);
+      }
+    }
+  }
+  return result;
+}
+
 int luaLoad(const char *filename, ScriptInternalData & sid, ScriptInputsOutputs * sio=NULL)
 {
   int init = 0;
@@ -1586,7 +1832,7 @@ int luaLoad(const char *filename, ScriptInternalData & sid, ScriptInputsOutputs
   SET_LUA_INSTRUCTIONS_COUNT(MANUAL_SCRIPTS_MAX_INSTRUCTIONS);
 
   PROTECT_LUA() {
-    if (luaL_loadfile(L, filename) == 0 &&
+    if (luaLoadScriptFile(filename) == 0 &&
         lua_pcall(L, 0, 1, 0) == 0 &&
         lua_istable(L, -1)) {
 
@@ -1962,11 +2208,42 @@ bool luaDoOneRunPermanentScript(uint8_t evt, int i, uint32_t scriptType)
   return true;
 }
 
+// The Lua heap is fully collected when it uses 3/4 of the memory it may get: the memory it uses and the free
+// RAM between the heap and the stack, where the allocators take their blocks
+static int luaGetGcFullThreshold(int used)
+{
+#if defined(SIMU)
+  return LUA_SIMU_MEM_MAX*3/4;
+#else
+  return (used + getAvailableMemory())*3/4;
+#endif
+}
+
 void luaDoGc()
 {
   if (L) {
     PROTECT_LUA() {
-      lua_gc(L, LUA_GCCOLLECT, 0);
+      uint32_t start = getCycleCounter();
+      int used = luaGetMemUsed();
+      int threshold = luaGetGcFullThreshold(used);
+      if (used >= threshold) {
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        luaHeapAfterGc = luaGetMemUsed();
+      }
+      else {
+        uint32_t budget = (LUA_GC_BUDGET_MIN + (LUA_GC_BUDGET_MAX-LUA_GC_BUDGET_MIN) * used / threshold) * CYCLES_PER_US;
+        do {
+          if (lua_gc(L, LUA_GCSTEP, 0)) {
+            // the collection cycle is finished, the next one will start in the next call
+            luaHeapAfterGc = luaGetMemUsed();
+            break;
+          }
+        } while (getCycleCounter() - start < budget);
+      }
+      uint32_t duration = (getCycleCounter() - start) / CYCLES_PER_US;
+      if (duration > maxLuaGcDuration) {
+        maxLuaGcDuration = min<uint32_t>(duration, 0xFFFF);
+      }
 #if defined(SIMU) || defined(DEBUG)
       static int lastgc = 0;
       int gc = luaGetMemUsed();
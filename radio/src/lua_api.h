@@ -96,6 +96,7 @@
   void luaClose();
   bool luaTask(uint8_t evt, uint8_t scriptType, bool allowLcdUsage);
   void luaExec(const char *filename);
+  int luaLoadScriptFile(const char * filename);
   int luaGetMemUsed();
   #define luaGetCpuUsed(idx) scriptInternalData[idx].instructions
   #define LUA_LOAD_MODEL_SCRIPTS()   luaState |= INTERPRETER_RELOAD_PERMANENT_SCRIPTS
@@ -117,7 +118,13 @@
 
   extern uint16_t maxLuaInterval;
   extern uint16_t maxLuaDuration;
+  extern uint16_t maxLuaGcDuration;
+  extern int luaHeapAfterGc;
+  void luaDoGc();
+  extern bool luaSensorNamesValid;
+  inline void luaSensorNamesInvalidate() { luaSensorNamesValid = false; }
 #else  // #if defined(LUA)
+  #define luaSensorNamesInvalidate()
   #define LUA_LOAD_MODEL_SCRIPTS()
   #define LUA_LOAD_MODEL_SCRIPT(idx)
   #define LUA_STANDALONE_SCRIPT_RUNNING() (0)
@@ -176,6 +176,12 @@ void perMain()
     drawStatusLine();
   }
 
+  // the model edits of this cycle are done
+  if (modelChanged) {
+    modelChanged = false;
+    modelCachesInvalidate();
+  }
+
 #if defined(REV9E) && !defined(SIMU)
   uint32_t pwr_pressed_duration = pwrPressedDuration();
   if (pwr_pressed_duration > 0) {
@@ -165,19 +165,93 @@ void applyExpos(int16_t *anas, uint8_t mode APPLY_EXPOS_EXTRA_PARAMS)
 // value = outputvalue with 100 mulitplied usual range -102400 to 102400; output -1024 to 1024
 // changed rescaling from *100 to *256 to optimize performance
 // rescaled from -262144 to 262144
-int16_t applyLimits(uint8_t channel, int32_t value)
+#if defined(CPUARM)
+LimitCache limitsCache[NUM_CHNOUT];
+uint8_t limitsCacheValid = 0;
+
+void limitCacheUpdate(uint8_t channel)
 {
   LimitData * lim = limitAddress(channel);
+  LimitCache & cache = limitsCache[channel];
 
+  int16_t ofs   = LIMIT_OFS_RESX(lim);
+  int16_t lim_p = LIMIT_MAX_RESX(lim);
+  int16_t lim_n = LIMIT_MIN_RESX(lim);
+
+  if (ofs > lim_p) ofs = lim_p;
+  if (ofs < lim_n) ofs = lim_n;
+
+  cache.ofs = ofs;
+  cache.min = lim_n;
+  cache.max = lim_p;
+#if defined(PPM_LIMITS_SYMETRICAL)
+  if (lim->symetrical) {
+    cache.scalePos = lim_p;
+    cache.scaleNeg = -lim_n;
+  }
+  else
+#endif
+  {
+    cache.scalePos = lim_p - ofs;
+    cache.scaleNeg = -lim_n + ofs;
+  }
 #if defined(PCBTARANIS)
-  if (lim->curve) {
-    // TODO we loose precision here, applyCustomCurve could work with int32_t on ARM boards...
-    if (lim->curve > 0)
-      value = 256 * applyCustomCurve(value/256, lim->curve-1);
-    else
-      value = 256 * applyCustomCurve(-value/256, -lim->curve-1);
+  cache.curve = lim->curve;
+#else
+  cache.curve = 0;
+#endif
+  cache.flags = (lim->revert ? LIMIT_CACHE_REVERT : 0) | (LIMIT_GVARS(lim) ? LIMIT_CACHE_GVARS : 0);
+}
+
+void limitsCacheUpdate()
+{
+  for (uint8_t i=0; i<NUM_CHNOUT; i++) {
+    limitCacheUpdate(i);
   }
+  limitsCacheValid = 1;
+}
+
+#if defined(PCBTARANIS)
+// The curve is applied on both sides of the value, then interpolated, so that the 1/256 resolution
+// of the mixer output is kept
+int32_t applyLimitCurve(int32_t value, int8_t curve)
+{
+  uint8_t idx = (curve > 0 ? curve-1 : -curve-1);
+  if (curve < 0) value = -value;
+  int32_t x = value >> 8;
+  int32_t frac = value & 0xff;
+  int32_t result = 256 * applyCustomCurve(x, idx);
+  if (frac) {
+    result += (256 * applyCustomCurve(x+1, idx) - result) * frac / 256;
+  }
+  return result;
+}
 #endif
+#endif
+
+int16_t applyLimits(uint8_t channel, int32_t value)
+{
+#if defined(CPUARM)
+  if (!limitsCacheValid) {
+    limitsCacheUpdate();
+  }
+
+  const LimitCache & cache = limitsCache[channel];
+  if (cache.flags & LIMIT_CACHE_GVARS) {
+    limitCacheUpdate(channel);
+  }
+
+#if defined(PCBTARANIS)
+  if (cache.curve) {
+    value = applyLimitCurve(value, cache.curve);
+  }
+#endif
+
+  int16_t ofs   = cache.ofs;
+  int16_t lim_p = cache.max;
+  int16_t lim_n = cache.min;
+#else
+  LimitData * lim = limitAddress(channel);
 
   int16_t ofs   = LIMIT_OFS_RESX(lim);
   int16_t lim_p = LIMIT_MAX_RESX(lim);
@@ -185,6 +259,7 @@ int16_t applyLimits(uint8_t channel, int32_t value)
 
   if (ofs > lim_p) ofs = lim_p;
   if (ofs < lim_n) ofs = lim_n;
+#endif
 
   // because the rescaling optimization would reduce the calculation reserve we activate this for all builds
   // it increases the calculation reserve from factor 20,25x to 32x, which it slightly better as original
@@ -194,7 +269,11 @@ int16_t applyLimits(uint8_t channel, int32_t value)
   // unfortunately the constants and 32bit compares generates about 50 bytes codes; didn't find a way to get it down.
   value = limit(int32_t(-RESXl*256), value, int32_t(RESXl*256));  // saves 2 bytes compared to other solutions up to now
 
-#if defined(PPM_LIMITS_SYMETRICAL)
+#if defined(CPUARM)
+  if (value) {
+    int16_t tmp = (value > 0) ? cache.scalePos : cache.scaleNeg;
+    value = (int32_t) value * tmp;   //  div by 1024*256 -> output = -1024..1024
+#elif defined(PPM_LIMITS_SYMETRICAL)
   if (value) {
     int16_t tmp;
     if (lim->symetrical)
@@ -225,7 +304,11 @@ int16_t applyLimits(uint8_t channel, int32_t value)
   if (ofs > lim_p) ofs = lim_p;
   if (ofs < lim_n) ofs = lim_n;
 
+#if defined(CPUARM)
+  if (cache.flags & LIMIT_CACHE_REVERT) ofs = -ofs; // finally do the reverse.
+#else
   if (lim->revert) ofs = -ofs; // finally do the reverse.
+#endif
 
 #if defined(OVERRIDE_CHANNEL_FUNCTION)
   if (safetyCh[channel] != OVERRIDE_CHANNEL_UNDEFINED) {
@@ -239,26 +322,233 @@ int16_t applyLimits(uint8_t channel, int32_t value)
 
 // TODO same naming convention than the putsMixerSource
 
-getvalue_t getValue(mixsrc_t i)
+#if defined(CPUARM)
+// The sources are split into ranges of the same kind, each one read by its handler from the index of
+// the source inside the range. getValue() finds the range by a binary search in the (const) table below
+
+typedef getvalue_t (*SourceHandler)(uint16_t index);
+
+struct SourceRange {
+  mixsrc_t first;
+  SourceHandler handler;
+  bool snapshot; // the value can't change during one evaluation of the mixes
+};
+
+static getvalue_t getNoneSourceValue(uint16_t index)
 {
-  if (i==MIXSRC_NONE) return 0;
+  return 0;
+}
 
 #if defined(VIRTUALINPUTS)
-  else if (i <= MIXSRC_LAST_INPUT) {
-    return anas[i-MIXSRC_FIRST_INPUT];
-  }
-#endif
+static getvalue_t getInputSourceValue(uint16_t index)
+{
+  return anas[index];
+}
 
-#if defined(LUAINPUTS)
-  else if (i<MIXSRC_LAST_LUA) {
+static getvalue_t getLuaSourceValue(uint16_t index)
+{
 #if defined(LUA_MODEL_SCRIPTS)
-    div_t qr = div(i-MIXSRC_FIRST_LUA, MAX_SCRIPT_OUTPUTS);
-    return scriptInputsOutputs[qr.quot].outputs[qr.rem].value;
+  div_t qr = div(index, MAX_SCRIPT_OUTPUTS);
+  return scriptInputsOutputs[qr.quot].outputs[qr.rem].value;
 #else
+  return 0;
+#endif
+}
+#endif
+
+static getvalue_t getStickSourceValue(uint16_t index)
+{
+  return calibratedStick[index];
+}
+
+#if defined(PCBSKY9X)
+static getvalue_t getRotaryEncoderSourceValue(uint16_t index)
+{
+#if defined(ROTARY_ENCODERS)
+  return getRotaryEncoder(index);
+#else
+  return 0;
+#endif
+}
+#endif
+
+static getvalue_t getMaxSourceValue(uint16_t index)
+{
+  return 1024;
+}
+
+static getvalue_t getCyclicSourceValue(uint16_t index)
+{
+#if defined(HELI)
+  return cyc_anas[index];
+#else
+  return 0;
+#endif
+}
+
+static getvalue_t getTrimSourceValue(uint16_t index)
+{
+  return calc1000toRESX((int16_t)8 * getTrimValue(mixerCurrentFlightMode, index));
+}
+
+static getvalue_t getSwitchSourceValue(uint16_t index)
+{
+#if defined(PCBTARANIS)
+  if (SWITCH_EXISTS(index)) {
+    return (switchState((EnumKeys)(SW_BASE+(3*index))) ? -1024 : (switchState((EnumKeys)(SW_BASE+(3*index)+1)) ? 0 : 1024));
+  }
+  else {
     return 0;
+  }
+#else
+  if (index == MIXSRC_3POS-MIXSRC_FIRST_SWITCH)
+    return (getSwitch(SW_ID0-SW_BASE+1) ? -1024 : (getSwitch(SW_ID1-SW_BASE+1) ? 0 : 1024));
+  // don't use switchState directly to give getSwitch possibility to hack values if needed for switch warning
+  else
+    return getSwitch(SWSRC_THR+MIXSRC_FIRST_SWITCH+index-MIXSRC_THR) ? 1024 : -1024;
 #endif
+}
+
+static getvalue_t getLogicalSwitchSourceValue(uint16_t index)
+{
+  return getSwitch(SWSRC_FIRST_LOGICAL_SWITCH+index) ? 1024 : -1024;
+}
+
+static getvalue_t getTrainerSourceValue(uint16_t index)
+{
+  int16_t x = g_ppmIns[index];
+  if (index < NUM_CAL_PPM) {
+    x -= g_eeGeneral.trainer.calib[index];
   }
+  return x*2;
+}
+
+static getvalue_t getChannelSourceValue(uint16_t index)
+{
+  return ex_chans[index];
+}
+
+static getvalue_t getGVarSourceValue(uint16_t index)
+{
+#if defined(GVARS)
+  return GVAR_VALUE(index, getGVarFlightPhase(mixerCurrentFlightMode, index));
+#else
+  return 0;
+#endif
+}
+
+static getvalue_t getTxVoltageSourceValue(uint16_t index)
+{
+  return g_vbat100mV;
+}
+
+static getvalue_t getTxTimeSourceValue(uint16_t index)
+{
+  // TX_TIME + SPARES
+#if defined(RTCLOCK)
+  return (g_rtcTime % SECS_PER_DAY) / 60; // number of minutes from midnight
+#else
+  return 0;
+#endif
+}
+
+static getvalue_t getTimerSourceValue(uint16_t index)
+{
+  return timersStates[index].val;
+}
+
+static getvalue_t getTelemetrySourceValue(uint16_t index)
+{
+  div_t qr = div(index, 3);
+  TelemetryItem & telemetryItem = telemetryItems[qr.quot];
+  switch (qr.rem) {
+    case 1:
+      return telemetryItem.valueMin;
+    case 2:
+      return telemetryItem.valueMax;
+    default:
+      return telemetryItem.value;
+  }
+}
+
+// The logical switches change during their evaluation and the cyclic is computed after them,
+// these ones are never taken from the snapshot
+const SourceRange sourceRanges[] = {
+  { MIXSRC_NONE, getNoneSourceValue, false },
+#if defined(VIRTUALINPUTS)
+  { MIXSRC_FIRST_INPUT, getInputSourceValue, true },
+  { MIXSRC_FIRST_LUA, getLuaSourceValue, true },
+#endif
+  { MIXSRC_FIRST_STICK, getStickSourceValue, true },
+#if defined(PCBSKY9X)
+  { MIXSRC_REa, getRotaryEncoderSourceValue, true },
 #endif
+  { MIXSRC_MAX, getMaxSourceValue, true },
+  { MIXSRC_FIRST_HELI, getCyclicSourceValue, false },
+  { MIXSRC_FIRST_TRIM, getTrimSourceValue, true },
+  { MIXSRC_FIRST_SWITCH, getSwitchSourceValue, true },
+  { MIXSRC_FIRST_LOGICAL_SWITCH, getLogicalSwitchSourceValue, false },
+  { MIXSRC_FIRST_TRAINER, getTrainerSourceValue, true },
+  { MIXSRC_FIRST_CH, getChannelSourceValue, true },
+  { MIXSRC_FIRST_GVAR, getGVarSourceValue, true },
+  { MIXSRC_TX_VOLTAGE, getTxVoltageSourceValue, true },
+  { MIXSRC_TX_TIME, getTxTimeSourceValue, true },
+  { MIXSRC_FIRST_TIMER, getTimerSourceValue, true },
+  { MIXSRC_FIRST_TELEM, getTelemetrySourceValue, true },
+  { MIXSRC_LAST_TELEM+1, getNoneSourceValue, false },
+};
+
+static const SourceRange * getSourceRange(mixsrc_t i)
+{
+  uint8_t lo = 0, hi = DIM(sourceRanges) - 1;
+  while (lo < hi) {
+    uint8_t mid = (lo + hi + 1) / 2;
+    if (sourceRanges[mid].first <= i)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return &sourceRanges[lo];
+}
+
+// The snapshot keeps the values read during one evaluation of the mixes, so that the sources read by
+// several expos, mixes and logical switches are resolved only once. It is filled lazily, a value is
+// valid when its stamp is the one of the current evaluation
+getvalue_t sourcesSnapshotValues[MIXSRC_LAST_TELEM+1];
+uint8_t sourcesSnapshotStamps[MIXSRC_LAST_TELEM+1];
+uint8_t sourcesSnapshotStamp = 0; // 0 when no snapshot is active
+uint8_t sourcesSnapshotLastStamp = 0;
+
+void sourcesSnapshotStart()
+{
+  if (++sourcesSnapshotLastStamp == 0) {
+    memclear(sourcesSnapshotStamps, sizeof(sourcesSnapshotStamps));
+    sourcesSnapshotLastStamp = 1;
+  }
+  sourcesSnapshotStamp = sourcesSnapshotLastStamp;
+}
+
+void sourcesSnapshotStop()
+{
+  sourcesSnapshotStamp = 0;
+}
+
+getvalue_t getValue(mixsrc_t i)
+{
+  const SourceRange * range = getSourceRange(i);
+  if (sourcesSnapshotStamp && range->snapshot) {
+    if (sourcesSnapshotStamps[i] != sourcesSnapshotStamp) {
+      sourcesSnapshotValues[i] = range->handler(i - range->first);
+      sourcesSnapshotStamps[i] = sourcesSnapshotStamp;
+    }
+    return sourcesSnapshotValues[i];
+  }
+  return range->handler(i - range->first);
+}
+#else
+getvalue_t getValue(mixsrc_t i)
+{
+  if (i==MIXSRC_NONE) return 0;
 
   else if (i<=MIXSRC_LAST_POT) return calibratedStick[i-MIXSRC_Rud];
 
@@ -300,35 +590,10 @@ getvalue_t getValue(mixsrc_t i)
   else if (i<=MIXSRC_LAST_GVAR) return GVAR_VALUE(i-MIXSRC_GVAR1, getGVarFlightPhase(mixerCurrentFlightMode, i-MIXSRC_GVAR1));
 #endif
 
-#if defined(CPUARM)
-  else if (i==MIXSRC_TX_VOLTAGE) return g_vbat100mV;
-  else if (i<MIXSRC_FIRST_TIMER) // TX_TIME + SPARES
-  #if defined(RTCLOCK)
-     return (g_rtcTime % SECS_PER_DAY) / 60; // number of minutes from midnight
-  #else
-     return 0;
-  #endif
-  else if (i<=MIXSRC_LAST_TIMER) return timersStates[i-MIXSRC_FIRST_TIMER].val;
-#else
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_TX_VOLTAGE) return g_vbat100mV;
   else if (i<=MIXSRC_FIRST_TELEM-1+TELEM_TIMER2) return timersStates[i-MIXSRC_FIRST_TELEM+1-TELEM_TIMER1].val;
-#endif
 
-#if defined(CPUARM)
-  else if (i<=MIXSRC_LAST_TELEM) {
-    i -= MIXSRC_FIRST_TELEM;
-    div_t qr = div(i, 3);
-    TelemetryItem & telemetryItem = telemetryItems[qr.quot];
-    switch (qr.rem) {
-      case 1:
-        return telemetryItem.valueMin;
-      case 2:
-        return telemetryItem.valueMax;
-      default:
-        return telemetryItem.value;
-    }
-  }
-#elif defined(FRSKY)
+#if defined(FRSKY)
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_RSSI_TX) return frskyData.rssi[1].value;
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_RSSI_RX) return frskyData.rssi[0].value;
   else if (i==MIXSRC_FIRST_TELEM-1+TELEM_A1) return frskyData.analog[TELEM_ANA_A1].value;
@@ -366,6 +631,7 @@ getvalue_t getValue(mixsrc_t i)
 #endif
   else return 0;
 }
+#endif
 
 void evalInputs(uint8_t mode)
 {
@@ -539,12 +805,307 @@ int getSourceTrimValue(int source, int value=0)
 }
 #endif
 
+#if defined(CPUARM)
+MixerPlan mixerPlan;
+
+#if defined(GVARS)
+  #define IS_GVAR_USED(x, min, max)  GV_IS_GV_VALUE(x, min, max)
+#else
+  #define IS_GVAR_USED(x, min, max)  false
+#endif
+
+// The logical switches have one state per flight mode, the flight mode switches follow the flight mode
+bool isSwitchFlightModeDependent(int swtch)
+{
+  swtch = abs(swtch);
+  return (swtch >= SWSRC_FIRST_LOGICAL_SWITCH && swtch <= SWSRC_LAST_LOGICAL_SWITCH) || (swtch >= SWSRC_FIRST_FLIGHT_MODE && swtch <= SWSRC_LAST_FLIGHT_MODE);
+}
+
+bool isSourceFlightModeDependent(int source, uint32_t inputs, bitfield_channels_t channels)
+{
+#if defined(VIRTUALINPUTS)
+  if (source >= MIXSRC_FIRST_INPUT && source <= MIXSRC_LAST_INPUT)
+    return inputs & ((uint32_t)1 << (source-MIXSRC_FIRST_INPUT));
+#endif
+  if (source >= MIXSRC_FIRST_CH && source <= MIXSRC_LAST_CH)
+    return channels & ((bitfield_channels_t)1 << (source-MIXSRC_FIRST_CH));
+  return (source >= MIXSRC_FIRST_HELI && source <= MIXSRC_LAST_TRIM) ||
+         (source >= MIXSRC_FIRST_LOGICAL_SWITCH && source <= MIXSRC_LAST_LOGICAL_SWITCH) ||
+         (source >= MIXSRC_FIRST_GVAR && source <= MIXSRC_LAST_GVAR);
+}
+
+#if defined(XCURVES)
+bool isCurveFlightModeDependent(const CurveRef & curve)
+{
+  return (curve.type == CURVE_REF_DIFF || curve.type == CURVE_REF_EXPO) && IS_GVAR_USED(curve.value, -100, 100);
+}
+#endif
+
+// The inputs with an expo line which may be disabled or computed differently in another flight mode
+uint32_t getFlightModeDependentInputs()
+{
+  uint32_t result = 0;
+  for (uint8_t i=0; i<MAX_EXPOS; i++) {
+    ExpoData * ed = expoAddress(i);
+    if (!EXPO_VALID(ed)) break;
+    if (ed->flightModes || isSwitchFlightModeDependent(ed->swtch) ||
+#if defined(VIRTUALINPUTS)
+        isSourceFlightModeDependent(ed->srcRaw, (uint32_t)-1, 0) ||
+        IS_GVAR_USED(ed->offset, -100, 100) ||
+#endif
+#if defined(XCURVES)
+        isCurveFlightModeDependent(ed->curve) ||
+#else
+        (ed->curveMode != MODE_CURVE && IS_GVAR_USED(ed->curveParam, -100, 100)) ||
+#endif
+        IS_GVAR_USED(ed->weight, MIN_EXPO_WEIGHT, 100)) {
+      result |= (uint32_t)1 << ed->chn;
+    }
+  }
+  return result;
+}
+
+// A mix line which depends on the flight mode, either through its own settings or through its source. Lines with
+// a delay or a slow are included, as they are evaluated differently when their flight mode is not the active one
+bool isMixFlightModeDependent(MixData * md, uint32_t inputs, bitfield_channels_t channels)
+{
+  if (md->flightModes || isSwitchFlightModeDependent(md->swtch) ||
+      md->delayUp || md->delayDown || md->speedUp || md->speedDown ||
+      IS_GVAR_USED(MD_WEIGHT(md), GV_RANGELARGE_NEG, GV_RANGELARGE) ||
+      IS_GVAR_USED(MD_OFFSET(md), GV_RANGELARGE_NEG, GV_RANGELARGE)) {
+    return true;
+  }
+
+  // the trims have one value per flight mode
+#if defined(VIRTUALINPUTS)
+  if (md->carryTrim == 0 && ((md->srcRaw >= MIXSRC_Rud && md->srcRaw <= MIXSRC_Ail) || (md->srcRaw >= MIXSRC_FIRST_INPUT && md->srcRaw <= MIXSRC_LAST_INPUT)))
+    return true;
+#else
+  mixsrc_t stickIndex = md->srcRaw - MIXSRC_Rud;
+  if (md->carryTrim < TRIM_ON || (md->carryTrim == TRIM_ON && stickIndex < NUM_STICKS))
+    return true;
+#endif
+
+#if defined(XCURVES)
+  if (isCurveFlightModeDependent(md->curve))
+    return true;
+#else
+  if (md->curveMode == MODE_DIFFERENTIAL && IS_GVAR_USED(md->curveParam, -100, 100))
+    return true;
+#endif
+
+#if !defined(VIRTUALINPUTS)
+  if (stickIndex < NUM_STICKS)
+    return !md->noExpo && (inputs & ((uint32_t)1 << stickIndex));
+#endif
+
+  return isSourceFlightModeDependent(md->srcRaw, inputs, channels);
+}
+
+void mixerPlanUpdate()
+{
+  bitfield_channels_t used = 0;             // channels which have mix lines
+  bitfield_channels_t deps[NUM_CHNOUT];     // channels read by the mix lines of each channel
+  uint8_t first[NUM_CHNOUT];
+  uint8_t count;
+  bool ordered = true;
+
+  memclear(deps, sizeof(deps));
+
+  for (count=0; count<MAX_MIXERS; count++) {
+    MixData * md = mixAddress(count);
+    if (md->srcRaw == 0) break;
+    bitfield_channels_t mask = (bitfield_channels_t)1 << md->destCh;
+    if (!(used & mask)) {
+      used |= mask;
+      first[md->destCh] = count;
+    }
+    else if (md->destCh != (md-1)->destCh) {
+      ordered = false; // the lines of this channel are not contiguous
+    }
+    if (md->srcRaw >= MIXSRC_CH1 && md->srcRaw <= MIXSRC_LAST_CH && md->srcRaw-MIXSRC_CH1 != md->destCh) {
+      deps[md->destCh] |= (bitfield_channels_t)1 << (md->srcRaw-MIXSRC_CH1);
+    }
+    mixerPlan.lines[count] = count;
+  }
+
+  // Replay the dirty channels propagation of the multi-pass loop. A single pass in the dependency
+  // order gives the same outputs only if each channel was finally computed from up-to-date sources,
+  // and if no line with a delay or a slow (which keep a state) was ever evaluated with an outdated one
+  bitfield_channels_t dirty = (bitfield_channels_t)-1;
+  bitfield_channels_t uptodate = ~used;     // channels without mix lines are always 0
+  for (uint8_t pass=0; ordered && dirty && pass<5; pass++) {
+    bitfield_channels_t passDirty = 0;
+    for (uint8_t i=0; i<count; i++) {
+      MixData * md = mixAddress(i);
+      bitfield_channels_t mask = (bitfield_channels_t)1 << md->destCh;
+      if (!(dirty & mask)) continue;
+      if (i == 0 || md->destCh != (md-1)->destCh) {
+        uptodate |= mask;
+      }
+      if (md->srcRaw >= MIXSRC_CH1 && md->srcRaw <= MIXSRC_LAST_CH && md->srcRaw-MIXSRC_CH1 != md->destCh) {
+        uint8_t src = md->srcRaw - MIXSRC_CH1;
+        bitfield_channels_t srcMask = (bitfield_channels_t)1 << src;
+        if (dirty & srcMask & (passDirty | ~(mask-1)))
+          passDirty |= mask;
+        if (!(uptodate & srcMask) || (pass == 0 && src > md->destCh && (used & srcMask))) {
+          uptodate &= ~mask;
+          if (md->delayUp || md->delayDown || md->speedUp || md->speedDown)
+            ordered = false;
+        }
+      }
+    }
+    dirty &= passDirty;
+  }
+
+  if (uptodate != (bitfield_channels_t)-1) {
+    ordered = false; // loop between channels, or too many passes needed
+  }
+
+  if (ordered) {
+    bitfield_channels_t done = ~used;
+    uint8_t k = 0;
+    while (k < count) {
+      uint8_t previous = k;
+      for (uint8_t ch=0; ch<NUM_CHNOUT; ch++) {
+        bitfield_channels_t mask = (bitfield_channels_t)1 << ch;
+        if (!(done & mask) && !(deps[ch] & ~done)) {
+          for (uint8_t i=first[ch]; i<count && mixAddress(i)->destCh==ch; i++) {
+            mixerPlan.lines[k++] = i;
+          }
+          done |= mask;
+        }
+      }
+      if (k == previous) {
+        // should not happen, the dependencies have been checked above
+        for (k=0; k<count; k++) mixerPlan.lines[k] = k;
+        ordered = false;
+        break;
+      }
+    }
+  }
+
+  bitfield_channels_t fadeChannels = (bitfield_channels_t)-1;
+  if (ordered) {
+    // a channel is evaluated after all the channels it reads
+    uint32_t inputs = getFlightModeDependentInputs();
+    fadeChannels = 0;
+    for (uint8_t k=0; k<count; k++) {
+      MixData * md = mixAddress(mixerPlan.lines[k]);
+      if (isMixFlightModeDependent(md, inputs, fadeChannels)) {
+        fadeChannels |= (bitfield_channels_t)1 << md->destCh;
+      }
+    }
+  }
+
+  mixerPlan.count = count;
+  mixerPlan.fadeChannels = fadeChannels;
+  mixerPlan.state = (ordered ? MIXER_PLAN_ORDERED : MIXER_PLAN_MULTIPASS);
+}
+#endif
+
+#if defined(CPUARM)
+MixerStageStatistics mixerStages[MIXER_STAGES_COUNT];
+uint32_t mixerStagesCycles[MIXER_STAGES_COUNT];
+uint16_t mixerStagesDone = 0;
+
+const char * const mixerStagesNames[MIXER_STAGES_COUNT] = {
+  "adc",
+  "switches",
+  "inputs",
+  "logicalSwitches",
+  "mixes",
+  "functions",
+  "limits",
+  "timers"
+};
+
+void MixerStageStatistics::add(uint32_t duration)
+{
+  if (count == 0) {
+    min = max = duration;
+    avg16 = duration * 16;
+  }
+  else {
+    if (duration < min) min = duration;
+    if (duration > max) max = duration;
+    avg16 += duration - avg16 / 16;
+  }
+  count++;
+
+  uint8_t bin = 0;
+  for (uint32_t limit=16; duration >= limit && bin < MIXER_STAGE_HISTOGRAM_BINS-1; limit <<= 1) {
+    bin++;
+  }
+  if (histogram[bin] == 0xffff) {
+    // the older durations count for half
+    for (uint8_t i=0; i<MIXER_STAGE_HISTOGRAM_BINS; i++) {
+      histogram[i] /= 2;
+    }
+  }
+  histogram[bin]++;
+}
+
+void mixerStagesCommit()
+{
+  for (uint8_t i=0; i<MIXER_STAGES_COUNT; i++) {
+    if (mixerStagesDone & (1 << i)) {
+      mixerStages[i].add(mixerStagesCycles[i] / CYCLES_PER_US);
+      mixerStagesCycles[i] = 0;
+    }
+  }
+  mixerStagesDone = 0;
+
+#if defined(SIMU)
+  static uint16_t count = 0;
+  if (++count == 1000) {
+    count = 0;
+    mixerStagesTrace();
+  }
+#endif
+}
+
+void mixerStagesReset()
+{
+  for (uint8_t i=0; i<MIXER_STAGES_COUNT; i++) {
+    mixerStages[i].reset();
+  }
+}
+
+void mixerStagesTrace()
+{
+  for (uint8_t i=0; i<MIXER_STAGES_COUNT; i++) {
+    const MixerStageStatistics & stage = mixerStages[i];
+    if (stage.count) {
+      const uint16_t * h = stage.histogram;
+      TRACE("Mixer stage %-16s min=%uus avg=%uus max=%uus histogram=%d,%d,%d,%d,%d,%d,%d,%d", mixerStagesNames[i],
+            (unsigned)stage.min, (unsigned)stage.avg(), (unsigned)stage.max, h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+    }
+  }
+}
+#endif
+
 uint8_t mixerCurrentFlightMode;
+#if defined(CPUARM)
+// When channels is not all the channels, only these ones are evaluated, the others keep their value in chans[]
+void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms, bitfield_channels_t channels)
+#else
 void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
+#endif
 {
+  MIXER_STAGE_START(stageStart);
+
   evalInputs(mode);
+  MIXER_STAGE_END(INPUTS, stageStart);
 
-  if (tick10ms) evalLogicalSwitches(mode==e_perout_mode_normal);
+#if defined(CPUARM)
+  sourcesSnapshotStart();
+#endif
+
+  if (tick10ms) {
+    evalLogicalSwitches(mode==e_perout_mode_normal);
+    MIXER_STAGE_END(LOGICAL_SWITCHES, stageStart);
+  }
 
 #if defined(MODULE_ALWAYS_SEND_PULSES)
   checkStartupWarnings();
@@ -630,6 +1191,9 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
   }
 #endif
 
+#if defined(CPUARM)
+  if (channels == (bitfield_channels_t)-1)
+#endif
   memclear(chans, sizeof(chans));        // All outputs to 0
 
   //========== MIXER LOOP ===============
@@ -637,12 +1201,34 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
 
   uint8_t pass = 0;
 
+#if defined(CPUARM)
+  bitfield_channels_t dirtyChannels = channels;
+#else
   bitfield_channels_t dirtyChannels = (bitfield_channels_t)-1; // all dirty when mixer starts
+#endif
+
+#if defined(CPUARM)
+  if (mixerPlan.state == MIXER_PLAN_DIRTY) {
+    mixerPlanUpdate();
+  }
+  bool ordered = (mixerPlan.state == MIXER_PLAN_ORDERED);
+#endif
 
   do {
 
     bitfield_channels_t passDirtyChannels = 0;
 
+#if defined(CPUARM)
+    for (uint8_t k=0; k<mixerPlan.count; k++) {
+
+      uint8_t i = mixerPlan.lines[k];
+
+#if defined(BOLD_FONT)
+      if (mode==e_perout_mode_normal && pass==0) swOn[i].activeMix = 0;
+#endif
+
+      MixData *md = mixAddress(i);
+#else
     for (uint8_t i=0; i<MAX_MIXERS; i++) {
 
 #if defined(BOLD_FONT)
@@ -652,6 +1238,7 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
       MixData *md = mixAddress(i);
 
       if (md->srcRaw == 0) break;
+#endif
 
       mixsrc_t stickIndex = md->srcRaw - MIXSRC_Rud;
 
@@ -715,7 +1302,11 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
           if (srcRaw<=MIXSRC_LAST_CH-MIXSRC_CH1 && md->destCh != srcRaw) {
             if (dirtyChannels & ((bitfield_channels_t)1 << srcRaw) & (passDirtyChannels|~(((bitfield_channels_t) 1 << md->destCh)-1)))
               passDirtyChannels |= (bitfield_channels_t) 1 << md->destCh;
+#if defined(CPUARM)
+            if (ordered || srcRaw < md->destCh || pass > 0)
+#else
             if (srcRaw < md->destCh || pass > 0)
+#endif
               v = chans[srcRaw] >> 8;
           }
         }
@@ -940,9 +1531,19 @@ void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms)
     tick10ms = 0;
     dirtyChannels &= passDirtyChannels;
 
+#if defined(CPUARM)
+    if (ordered) break;
+#endif
+
   } while (++pass < 5 && dirtyChannels);
 
   mixWarning = lv_mixWarning;
+
+#if defined(CPUARM)
+  sourcesSnapshotStop();
+#endif
+
+  MIXER_STAGE_END(MIXES, stageStart);
 }
 
 int32_t sum_chans512[NUM_CHNOUT] = {0};
@@ -954,6 +1555,19 @@ uint8_t lastFlightMode = 255; // TODO reinit everything here when the model chan
 #if defined(CPUARM)
 tmr10ms_t flightModeTransitionTime;
 uint8_t   flightModeTransitionLast = 255;
+
+// not on the mixer task stack
+struct {
+  int16_t anas[NUM_INPUTS];
+  int16_t trims[NUM_STICKS];
+#if defined(VIRTUALINPUTS)
+  int8_t  virtualInputsTrims[NUM_INPUTS];
+#endif
+#if defined(HELI)
+  int16_t cyc_anas[3];
+#endif
+  uint8_t mixWarning;
+} fadeSavedInputs;
 #endif
 
 void evalMixes(uint8_t tick10ms)
@@ -1011,16 +1625,72 @@ void evalMixes(uint8_t tick10ms)
   int32_t weight = 0;
   if (flightModesFade) {
     memclear(sum_chans512, sizeof(sum_chans512));
-    for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
+#if defined(CPUARM)
+    if ((flightModesFade & ((ACTIVE_PHASES_TYPE)1 << fm)) && mixerPlan.fadeChannels != (bitfield_channels_t)-1) {
+      // the active flight mode is evaluated first, then only the channels which may have another
+      // value are evaluated again for the other flight modes. The other channels are blended once.
+      // The inactive flight modes see the slow values (act[]) already moved by the active one, where
+      // the loop below gives them the values of the previous cycle for the flight modes before it
       LS_RECURSIVE_EVALUATION_RESET();
-      if (flightModesFade & ((ACTIVE_PHASES_TYPE)1 << p)) {
-        mixerCurrentFlightMode = p;
-        evalFlightModeMixes(p==fm ? e_perout_mode_normal : e_perout_mode_inactive_flight_mode, p==fm ? tick10ms : 0);
-        for (uint8_t i=0; i<NUM_CHNOUT; i++)
-          sum_chans512[i] += (chans[i] >> 4) * fp_act[p];
-        weight += fp_act[p];
-      }
+      mixerCurrentFlightMode = fm;
+      evalFlightModeMixes(e_perout_mode_normal, tick10ms);
       LS_RECURSIVE_EVALUATION_RESET();
+      bitfield_channels_t fadeChannels = mixerPlan.fadeChannels;
+      for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
+        if (flightModesFade & ((ACTIVE_PHASES_TYPE)1 << p))
+          weight += fp_act[p];
+      }
+      for (uint8_t i=0; i<NUM_CHNOUT; i++) {
+        sum_chans512[i] = (chans[i] >> 4) * ((fadeChannels & ((bitfield_channels_t)1 << i)) ? fp_act[fm] : weight);
+      }
+      if (fadeChannels) {
+        // the inputs and trims of the active flight mode are kept for the functions and the display
+        memcpy(fadeSavedInputs.anas, anas, sizeof(anas));
+        memcpy(fadeSavedInputs.trims, trims, sizeof(trims));
+#if defined(VIRTUALINPUTS)
+        memcpy(fadeSavedInputs.virtualInputsTrims, virtualInputsTrims, sizeof(virtualInputsTrims));
+#endif
+#if defined(HELI)
+        memcpy(fadeSavedInputs.cyc_anas, cyc_anas, sizeof(cyc_anas));
+#endif
+        fadeSavedInputs.mixWarning = mixWarning;
+        for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
+          if (p != fm && (flightModesFade & ((ACTIVE_PHASES_TYPE)1 << p))) {
+            LS_RECURSIVE_EVALUATION_RESET();
+            mixerCurrentFlightMode = p;
+            evalFlightModeMixes(e_perout_mode_inactive_flight_mode, 0, fadeChannels);
+            for (uint8_t i=0; i<NUM_CHNOUT; i++) {
+              if (fadeChannels & ((bitfield_channels_t)1 << i))
+                sum_chans512[i] += (chans[i] >> 4) * fp_act[p];
+            }
+            LS_RECURSIVE_EVALUATION_RESET();
+          }
+        }
+        memcpy(anas, fadeSavedInputs.anas, sizeof(anas));
+        memcpy(trims, fadeSavedInputs.trims, sizeof(trims));
+#if defined(VIRTUALINPUTS)
+        memcpy(virtualInputsTrims, fadeSavedInputs.virtualInputsTrims, sizeof(virtualInputsTrims));
+#endif
+#if defined(HELI)
+        memcpy(cyc_anas, fadeSavedInputs.cyc_anas, sizeof(cyc_anas));
+#endif
+        mixWarning = fadeSavedInputs.mixWarning;
+      }
+    }
+    else
+#endif
+    {
+      for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
+        LS_RECURSIVE_EVALUATION_RESET();
+        if (flightModesFade & ((ACTIVE_PHASES_TYPE)1 << p)) {
+          mixerCurrentFlightMode = p;
+          evalFlightModeMixes(p==fm ? e_perout_mode_normal : e_perout_mode_inactive_flight_mode, p==fm ? tick10ms : 0);
+          for (uint8_t i=0; i<NUM_CHNOUT; i++)
+            sum_chans512[i] += (chans[i] >> 4) * fp_act[p];
+          weight += fp_act[p];
+        }
+        LS_RECURSIVE_EVALUATION_RESET();
+      }
     }
     assert(weight);
     mixerCurrentFlightMode = fm;
@@ -1034,6 +1704,8 @@ void evalMixes(uint8_t tick10ms)
   // must be done after mixing because some functions use the inputs/channels values
   // must be done before limits because of the applyLimit function: it checks for safety switches which would be not initialized otherwise
   if (tick10ms) {
+    MIXER_STAGE_START(functionsStart);
+
 #if defined(CPUARM)
     requiredSpeakerVolume = g_eeGeneral.speakerVolume + VOLUME_LEVEL_DEF;
 #endif
@@ -1046,9 +1718,15 @@ void evalMixes(uint8_t tick10ms)
 #else
     evalFunctions();
 #endif
+
+    MIXER_STAGE_END(FUNCTIONS, functionsStart);
   }
 
   //========== LIMITS ===============
+  MIXER_STAGE_START(limitsStart);
+#if defined(CPUARM)
+  int16_t outputs[NUM_CHNOUT];
+#endif
   for (uint8_t i=0; i<NUM_CHNOUT; i++) {
     // chans[i] holds data from mixer.   chans[i] = v*weight => 1024*256
     // later we multiply by the limit (up to 100) and then we need to normalize
@@ -1065,11 +1743,23 @@ void evalMixes(uint8_t tick10ms)
 
     int16_t value = applyLimits(i, q);  // applyLimits will remove the 256 100% basis
 
+#if defined(CPUARM)
+    outputs[i] = value;
+#else
     cli();
     channelOutputs[i] = value;  // copy consistent word to int-level
     sei();
+#endif
   }
 
+#if defined(CPUARM)
+  // all the channels are published at once, the pulses interrupts never see two different cycles in one frame
+  __disable_irq();
+  memcpy(channelOutputs, outputs, sizeof(channelOutputs));
+  __enable_irq();
+#endif
+  MIXER_STAGE_END(LIMITS, limitsStart);
+
   if (tick10ms && flightModesFade) {
     uint16_t tick_delta = delta * tick10ms;
     for (uint8_t p=0; p<MAX_FLIGHT_MODES; p++) {
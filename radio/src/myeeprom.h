@@ -876,6 +876,7 @@ PACK(typedef struct {
   #define LIMIT_MAX_RESX(lim) calc1000toRESX(LIMIT_MAX(lim))
   #define LIMIT_MIN_RESX(lim) calc1000toRESX(LIMIT_MIN(lim))
   #define LIMIT_OFS_RESX(lim) calc1000toRESX(LIMIT_OFS(lim))
+  #define LIMIT_GVARS(lim)    (GV_IS_GV_VALUE(lim->max, -GV_RANGELARGE, GV_RANGELARGE) || GV_IS_GV_VALUE(lim->min, -GV_RANGELARGE, GV_RANGELARGE) || GV_IS_GV_VALUE(lim->offset, -1000, 1000))
 #else
   #define limit_min_max_t     int8_t
   #define LIMIT_EXT_PERCENT   125
@@ -887,6 +888,7 @@ PACK(typedef struct {
   #define LIMIT_MAX_RESX(lim) calc100toRESX(LIMIT_MAX(lim))
   #define LIMIT_MIN_RESX(lim) calc100toRESX(LIMIT_MIN(lim))
   #define LIMIT_OFS_RESX(lim) calc1000toRESX(LIMIT_OFS(lim))
+  #define LIMIT_GVARS(lim)    (false)
 #endif
 
 #if defined(PCBTARANIS)
@@ -87,6 +87,9 @@ uint8_t unexpectedShutdown = 0;
 /* AVR: mixer duration in 1/16ms */
 /* ARM: mixer duration in 0.5us */
 uint16_t maxMixerDuration;
+#if defined(CPUARM)
+uint16_t channelOutputsSampleTime; // when the sticks of the current channelOutputs were sampled
+#endif
 
 #if defined(AUDIO) && !defined(CPUARM)
 audioQueue  audio;
@@ -1452,6 +1455,23 @@ void flightReset()
   RESET_THR_TRACE();
 }
 
+#if defined(CPUARM)
+bool modelChanged = false;
+
+void modelCachesInvalidate()
+{
+  mixerPlanInvalidate();
+  logicalSwitchesGraphInvalidate();
+  limitsCacheInvalidate();
+#if defined(XCURVES)
+  curveSplinesInvalidate();
+#endif
+  luaSensorNamesInvalidate();
+  telemetryRoutesInvalidate();
+  telemetryCalcGraphInvalidate();
+}
+#endif
+
 #if defined(THRTRACE)
 uint8_t  s_traceBuf[MAXTRACE];
 #if LCD_W >= 255
@@ -1508,14 +1528,24 @@ void doMixerCalculations()
   lastTMR = tmr10ms;
 #endif
 
+#if defined(CPUARM)
+  uint16_t sampleTime = getTmr2MHz();
+#endif
+
+  MIXER_STAGE_START(stageStart);
+
   getADC();
 
 #if defined(PCBTARANIS)
   processSbusInput();
 #endif
 
+  MIXER_STAGE_END(ADC, stageStart);
+
   getSwitchesPosition(!s_mixer_first_run_done);
 
+  MIXER_STAGE_END(SWITCHES, stageStart);
+
 #if defined(CPUARM)
   lastTMR = tmr10ms;
 #endif
@@ -1532,12 +1562,17 @@ void doMixerCalculations()
 
   evalMixes(tick10ms);
 
+#if defined(CPUARM)
+  channelOutputsSampleTime = sampleTime;
+#endif
+
 #if !defined(CPUARM)
   // Bandgap has had plenty of time to settle...
   getADC_bandgap();
 #endif
 
   if (tick10ms) {
+    MIXER_STAGE_START(timersStart);
 
 #if !defined(CPUM64) && !defined(ACCURAT_THROTTLE_TIMER)
     //  code cost is about 16 bytes for higher throttle accuracy for timer
@@ -1601,6 +1636,12 @@ void doMixerCalculations()
 
     evalTimers(val, tick10ms);
 
+    MIXER_STAGE_END(TIMERS, timersStart);
+
+#if defined(BINARY_LOGS)
+    sampleLogs();
+#endif
+
     static uint8_t  s_cnt_100ms;
     static uint8_t  s_cnt_1s;
     static uint8_t  s_cnt_samples_thr_1s;
@@ -1683,6 +1724,10 @@ void doMixerCalculations()
 #endif
   }
 
+#if defined(CPUARM)
+  mixerStagesCommit();
+#endif
+
   s_mixer_first_run_done = true;
 }
 
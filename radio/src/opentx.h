@@ -448,6 +448,20 @@ extern void boardInit();
 #endif
 
 #if defined(XCURVES)
+  // The points and tangents of the smooth curves, computed once for all the
+  // mixer cycles. A curve is loaded again when its bit in curveSplinesValid
+  // is cleared
+  struct CurveSpline {
+    int16_t x[MAX_POINTS];
+    int16_t y[MAX_POINTS];
+    int32_t m[MAX_POINTS];
+    uint8_t count;
+    bool monotone;
+  };
+  extern CurveSpline curveSplines[MAX_CURVES];
+  extern uint32_t curveSplinesValid;
+  void curveSplineLoad(uint8_t idx);
+  inline void curveSplinesInvalidate() { curveSplinesValid = 0; }
   void loadCurves();
   #define LOAD_MODEL_CURVES() loadCurves()
 #else
@@ -689,6 +703,39 @@ extern uint8_t flightModeTransitionLast;
   #define bitfield_channels_t uint16_t
 #endif
 
+#if defined(CPUARM)
+// The mix lines in the order they are evaluated by the mixer. When the
+// channels used as sources don't loop, the lines are sorted so that each
+// channel is computed before the mixes which read it, and the mixer does a
+// single pass. Otherwise the lines stay in the model order and the mixer
+// keeps the old multi-pass evaluation.
+// fadeChannels are the channels whose value may differ from one flight mode
+// to another. They are the only ones evaluated again for the other flight
+// modes during a fade. When all of them may differ, the fade keeps the
+// original evaluation of each flight mode in turn.
+enum MixerPlanState {
+  MIXER_PLAN_DIRTY,
+  MIXER_PLAN_ORDERED,
+  MIXER_PLAN_MULTIPASS
+};
+
+struct MixerPlan {
+  uint8_t state;
+  uint8_t count;
+  uint8_t lines[MAX_MIXERS];
+  bitfield_channels_t fadeChannels;
+};
+
+extern MixerPlan mixerPlan;
+void mixerPlanUpdate();
+inline void mixerPlanInvalidate()
+{
+  mixerPlan.state = MIXER_PLAN_DIRTY;
+}
+#else
+#define mixerPlanInvalidate()
+#endif
+
 #if defined(SIMU)
   inline int getAvailableMemory() { return 1000; }
 #elif defined(CPUARM) && !defined(SIMU)
@@ -699,7 +746,11 @@ extern uint8_t flightModeTransitionLast;
   #define getAvailableMemory() ((unsigned int)((unsigned char *)&_main_stack_start - heap))
 #endif
 
+#if defined(CPUARM)
+void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms, bitfield_channels_t channels=(bitfield_channels_t)-1);
+#else
 void evalFlightModeMixes(uint8_t mode, uint8_t tick10ms);
+#endif
 void evalMixes(uint8_t tick10ms);
 void doMixerCalculations();
 
@@ -710,6 +761,11 @@ void perMain();
 NOINLINE void per10ms();
 
 getvalue_t getValue(mixsrc_t i);
+#if defined(CPUARM)
+// Between these calls getValue() reads each source only once (except logical switches and cyclic)
+void sourcesSnapshotStart();
+void sourcesSnapshotStop();
+#endif
 
 #if defined(CPUARM)
 #define GETSWITCH_MIDPOS_DELAY   1
@@ -724,6 +780,8 @@ void logicalSwitchesReset();
 #if defined(CPUARM)
   void evalLogicalSwitches(bool isCurrentPhase=true);
   void logicalSwitchesCopyState(uint8_t src, uint8_t dst);
+  extern uint8_t logicalSwitchesGraphValid;
+  inline void logicalSwitchesGraphInvalidate() { logicalSwitchesGraphValid = 0; }
   #define LS_RECURSIVE_EVALUATION_RESET()
 #else
   #define evalLogicalSwitches(xxx)
@@ -872,9 +930,19 @@ extern uint8_t trimsDisplayMask;
 
 void flightReset();
 
+#if defined(CPUARM)
+// Set by eeDirty(EE_MODEL). The data computed from the model (mixer plan, ...)
+// are invalidated by perMain(), once the menus and scripts edits are done
+extern bool modelChanged;
+void modelCachesInvalidate();
+#endif
+
 extern uint8_t unexpectedShutdown;
 
 extern uint16_t maxMixerDuration;
+#if defined(CPUARM)
+extern uint16_t channelOutputsSampleTime;
+#endif
 
 #if !defined(CPUARM)
 extern uint8_t g_tmr1Latency_max;
@@ -888,6 +956,83 @@ extern uint16_t lastMixerDuration;
   #define DURATION_MS_PREC2(x) ((x)*100)/16
 #endif
 
+#if defined(CPUARM)
+// The cycle counter of the Cortex-M3 DWT unit (nanoseconds in the simulator)
+#if defined(SIMU)
+  uint32_t getCycleCounter();
+  #define cycleCounterInit()
+  #define CYCLES_PER_US            1000
+#else
+  #define ARM_DEMCR                (*(volatile uint32_t *)0xE000EDFC)
+  #define ARM_DWT_CTRL             (*(volatile uint32_t *)0xE0001000)
+  #define ARM_DWT_CYCCNT           (*(volatile uint32_t *)0xE0001004)
+  inline void cycleCounterInit() { ARM_DEMCR |= (1 << 24); ARM_DWT_CYCCNT = 0; ARM_DWT_CTRL |= 1; }
+  static inline uint32_t getCycleCounter() { return ARM_DWT_CYCCNT; }
+  #if defined(CPUSTM32)
+    #define CYCLES_PER_US          (SystemCoreClock / 1000000)
+  #else
+    #define CYCLES_PER_US          (Master_frequency / 1000000)
+  #endif
+#endif
+
+// The duration of each stage of doMixerCalculations(). A stage which runs several times in one
+// cycle (the mixes during the flight modes fades) is accumulated, then added to its statistics
+// at the end of the cycle
+enum MixerStages {
+  MIXER_STAGE_ADC,
+  MIXER_STAGE_SWITCHES,
+  MIXER_STAGE_INPUTS,
+  MIXER_STAGE_LOGICAL_SWITCHES,
+  MIXER_STAGE_MIXES,
+  MIXER_STAGE_FUNCTIONS,
+  MIXER_STAGE_LIMITS,
+  MIXER_STAGE_TIMERS,
+  MIXER_STAGES_COUNT
+};
+
+#define MIXER_STAGE_HISTOGRAM_BINS  8   // <16us, <32us, ..., <1024us, >=1024us
+
+struct MixerStageStatistics {
+  uint32_t count;
+  uint32_t min;   // us
+  uint32_t max;   // us
+  uint32_t avg16; // rolling average, us*16
+  uint16_t histogram[MIXER_STAGE_HISTOGRAM_BINS];
+  void reset()
+  {
+    memset(this, 0, sizeof(*this));
+  }
+  void add(uint32_t duration);
+  uint32_t avg() const
+  {
+    return avg16 / 16;
+  }
+};
+
+extern MixerStageStatistics mixerStages[MIXER_STAGES_COUNT];
+extern const char * const mixerStagesNames[MIXER_STAGES_COUNT];
+extern uint32_t mixerStagesCycles[MIXER_STAGES_COUNT];
+extern uint16_t mixerStagesDone;
+
+inline void mixerStageEnd(uint8_t stage, uint32_t & start)
+{
+  uint32_t now = getCycleCounter();
+  mixerStagesCycles[stage] += now - start;
+  mixerStagesDone |= (1 << stage);
+  start = now;
+}
+
+void mixerStagesCommit();
+void mixerStagesReset();
+void mixerStagesTrace();
+
+#define MIXER_STAGE_START(t)         uint32_t t = getCycleCounter()
+#define MIXER_STAGE_END(stage, t)    mixerStageEnd(MIXER_STAGE_##stage, t)
+#else
+#define MIXER_STAGE_START(t)
+#define MIXER_STAGE_END(stage, t)
+#endif
+
 #if defined(THRTRACE)
   #define MAXTRACE (LCD_W - 8)
   extern uint8_t  s_traceBuf[MAXTRACE];
@@ -906,7 +1051,9 @@ extern uint16_t lastMixerDuration;
   #define RESET_THR_TRACE() s_timeCum16ThrP = s_timeCumThr = 0
 #endif
 
-#if defined(CPUSTM32)
+#if defined(SIMU) && defined(CPUARM)
+  uint16_t getTmr2MHz();
+#elif defined(CPUSTM32)
   static inline uint16_t getTmr2MHz() { return TIM7->CNT; }
 #elif defined(CPUARM)
   static inline uint16_t getTmr2MHz() { return TC1->TC_CHANNEL[0].TC_CV; }
@@ -1028,6 +1175,7 @@ extern "C" {
 }
 #endif
 
+extern OS_TID mixerTaskId;
 extern OS_MutexID mixerMutex;
 inline void pauseMixerCalculations()
 {
@@ -1128,6 +1276,20 @@ extern uint16_t           BandGap;
 int intpol(int x, uint8_t idx);
 int expo(int x, int k);
 
+#if defined(CPUARM)
+  // The expo curves of the k values in use, see expoTableGet()
+  #define EXPO_TABLES         8
+  #define EXPO_TABLE_SHIFT    4
+  #define EXPO_TABLE_STEP     (1 << EXPO_TABLE_SHIFT)
+  #define EXPO_TABLE_POINTS   (RESX/EXPO_TABLE_STEP+1)
+  struct ExpoTable {
+    int8_t k;
+    int16_t y[EXPO_TABLE_POINTS+1];
+  };
+  ExpoTable * expoTableGet(int k);
+  int expoCubic(int x, int k);
+#endif
+
 #if defined(CURVES) && defined(XCURVES)
   int applyCurve(int x, CurveRef & curve);
 #elif defined(CURVES)
@@ -1172,6 +1334,28 @@ void defaultInputs();
 void applyExpos(int16_t *anas, uint8_t mode APPLY_EXPOS_EXTRA_PARAMS_INC);
 int16_t applyLimits(uint8_t channel, int32_t value);
 
+#if defined(CPUARM)
+// The constants of applyLimits() for one channel, computed when the model changes. The limits
+// which use a GVAR are computed again at each call
+struct LimitCache {
+  int16_t ofs;
+  int16_t min;
+  int16_t max;
+  int16_t scalePos;   // the output range above ofs
+  int16_t scaleNeg;   // the output range below ofs
+  int8_t  curve;
+  uint8_t flags;
+};
+
+#define LIMIT_CACHE_REVERT   0x01
+#define LIMIT_CACHE_GVARS    0x02
+
+extern LimitCache limitsCache[NUM_CHNOUT];
+extern uint8_t limitsCacheValid;
+void limitsCacheUpdate();
+inline void limitsCacheInvalidate() { limitsCacheValid = 0; }
+#endif
+
 void evalInputs(uint8_t mode);
 uint16_t anaIn(uint8_t chan);
 extern int16_t calibratedStick[NUM_STICKS+NUM_POTS];
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <string.h>
+#include "opentx.h"
+#include "pool_allocator.h"
+
+#if defined(USE_POOL_ALLOCATOR) || defined(SIMU)
+
+PoolAllocator_class1 pool1;
+PoolAllocator_class2 pool2;
+PoolAllocator_class3 pool3;
+PoolAllocator_class4 pool4;
+PoolAllocator_class5 pool5;
+
+// the blocks which did not fit in the pools, in the libc heap
+uint32_t poolLibcUsed = 0;
+uint32_t poolLibcMaxUsed = 0;
+uint32_t poolLibcAllocations = 0;
+
+// the pool of a block, found by its address, 0 if it is in the libc heap
+static uint8_t poolOf(void * ptr)
+{
+  if (pool1.is_member(ptr)) return 1;
+  if (pool2.is_member(ptr)) return 2;
+  if (pool3.is_member(ptr)) return 3;
+  if (pool4.is_member(ptr)) return 4;
+  if (pool5.is_member(ptr)) return 5;
+  return 0;
+}
+
+// the smallest pool of a size, 0 if it is too big for them
+static uint8_t poolClass(size_t size)
+{
+  if (size <= pool1.slotSize()) return 1;
+  if (size <= pool2.slotSize()) return 2;
+  if (size <= pool3.slotSize()) return 3;
+  if (size <= pool4.slotSize()) return 4;
+  if (size <= pool5.slotSize()) return 5;
+  return 0;
+}
+
+static size_t poolSlotSize(uint8_t pool)
+{
+  switch (pool) {
+    case 1: return pool1.slotSize();
+    case 2: return pool2.slotSize();
+    case 3: return pool3.slotSize();
+    case 4: return pool4.slotSize();
+    case 5: return pool5.slotSize();
+    default: return 0;
+  }
+}
+
+static void poolFree(uint8_t pool, void * ptr, size_t size)
+{
+  switch (pool) {
+    case 1: pool1.free(ptr, size); break;
+    case 2: pool2.free(ptr, size); break;
+    case 3: pool3.free(ptr, size); break;
+    case 4: pool4.free(ptr, size); break;
+    case 5: pool5.free(ptr, size); break;
+  }
+}
+
+static void poolResize(uint8_t pool, size_t oldSize, size_t newSize)
+{
+  switch (pool) {
+    case 1: pool1.resize(oldSize, newSize); break;
+    case 2: pool2.resize(oldSize, newSize); break;
+    case 3: pool3.resize(oldSize, newSize); break;
+    case 4: pool4.resize(oldSize, newSize); break;
+    case 5: pool5.resize(oldSize, newSize); break;
+  }
+}
+
+// a full pool gives its blocks to the bigger ones
+static void * poolMalloc(size_t size)
+{
+  void * res = NULL;
+  switch (poolClass(size)) {
+    case 1: res = pool1.malloc(size); if (res) break;
+    case 2: res = pool2.malloc(size); if (res) break;
+    case 3: res = pool3.malloc(size); if (res) break;
+    case 4: res = pool4.malloc(size); if (res) break;
+    case 5: res = pool5.malloc(size); break;
+  }
+  return res;
+}
+
+static void poolLibcResize(size_t oldSize, size_t newSize)
+{
+  poolLibcUsed += newSize - oldSize;
+  if (poolLibcUsed > poolLibcMaxUsed) {
+    poolLibcMaxUsed = poolLibcUsed;
+  }
+}
+
+void poolAllocatorClear()
+{
+  pool1.clear();
+  pool2.clear();
+  pool3.clear();
+  pool4.clear();
+  pool5.clear();
+  poolLibcUsed = poolLibcMaxUsed = poolLibcAllocations = 0;
+}
+
+#define POOL_STATS(idx, pool) \
+  stats.size[idx] = pool.slotSize(); \
+  stats.used[idx] = pool.size(); \
+  stats.maxUsed[idx] = pool.maxSize(); \
+  stats.capacity[idx] = pool.capacity(); \
+  stats.wasted += pool.wasted()
+
+void poolAllocatorGetStats(PoolAllocatorStats & stats)
+{
+  memclear(&stats, sizeof(stats));
+  stats.used[0] = poolLibcUsed;
+  stats.maxUsed[0] = poolLibcMaxUsed;
+  stats.libcAllocations = poolLibcAllocations;
+  POOL_STATS(1, pool1);
+  POOL_STATS(2, pool2);
+  POOL_STATS(3, pool3);
+  POOL_STATS(4, pool4);
+  POOL_STATS(5, pool5);
+}
+
+// the slot size of a block, 0 if it is in the libc heap
+size_t poolAllocatorSize(void * ptr)
+{
+  return poolSlotSize(poolOf(ptr));
+}
+
+// the bytes of the used slots and of the libc heap
+uint32_t poolAllocatorUsed()
+{
+  return pool1.size() * pool1.slotSize() + pool2.size() * pool2.slotSize() + pool3.size() * pool3.slotSize() +
+         pool4.size() * pool4.slotSize() + pool5.size() * pool5.slotSize() + poolLibcUsed;
+}
+
+// the high-water marks of the pools are not reached at the same time, this is an upper bound
+uint32_t poolAllocatorMaxUsed()
+{
+  return pool1.maxSize() * pool1.slotSize() + pool2.maxSize() * pool2.slotSize() + pool3.maxSize() * pool3.slotSize() +
+         pool4.maxSize() * pool4.slotSize() + pool5.maxSize() * pool5.slotSize() + poolLibcMaxUsed;
+}
+
+void * pool_l_alloc(void * ud, void * ptr, size_t osize, size_t nsize)
+{
+  (void)ud;
+  // osize is the type of the object when ptr is NULL
+  uint8_t pool = (ptr ? poolOf(ptr) : 0);
+
+  if (nsize == 0) {
+    if (pool) {
+      poolFree(pool, ptr, osize);
+    }
+    else if (ptr) {
+      poolLibcResize(osize, 0);
+      free(ptr);
+    }
+    return NULL;
+  }
+
+  if (pool) {
+    if (nsize <= poolSlotSize(pool)) {
+      // the block stays in its slot
+      poolResize(pool, osize, nsize);
+      return ptr;
+    }
+  }
+  else if (ptr) {
+    void * res = realloc(ptr, nsize);
+    if (res) {
+      poolLibcResize(osize, nsize);
+    }
+    return res;
+  }
+
+  void * res = poolMalloc(nsize);
+  if (!res) {
+    res = malloc(nsize);
+    if (!res) {
+      return NULL;
+    }
+    poolLibcResize(0, nsize);
+    poolLibcAllocations++;
+  }
+  if (ptr) {
+    memcpy(res, ptr, min(osize, nsize));
+    poolFree(pool, ptr, osize);
+  }
+  return res;
+}
+
+#endif // #if defined(USE_POOL_ALLOCATOR) || defined(SIMU)
@@ -0,0 +1,103 @@
+#ifndef poolallocator_h
+#define poolallocator_h
+
+#include <stddef.h>
+#include <inttypes.h>
+
+// A pool of slots of one size, the free slots are chained in a list stored in the slots themselves.
+// The slots after the initialized ones were never used, they are taken one by one when the free
+// list is empty, so that a pool in the BSS needs no constructor
+template <int SIZE_SLOT, int NUM_SLOTS> class PoolAllocator {
+private:
+  union Slot {
+    Slot * next;
+    double align;
+    uint8_t data[SIZE_SLOT];
+  };
+  Slot slots[NUM_SLOTS];
+  Slot * freeList;
+  uint16_t initialized;
+  uint16_t used;
+  uint16_t maxUsed;
+  uint32_t requested;   // the bytes requested in the used slots, the rest is lost
+public:
+  void clear() {
+    freeList = NULL;
+    initialized = used = maxUsed = 0;
+    requested = 0;
+  }
+  bool is_member(void * ptr) const {
+    return ptr >= (void *)&slots[0] && ptr < (void *)&slots[NUM_SLOTS];
+  }
+  void * malloc(size_t size) {
+    Slot * slot;
+    if (freeList) {
+      slot = freeList;
+      freeList = slot->next;
+    }
+    else if (initialized < NUM_SLOTS) {
+      slot = &slots[initialized++];
+    }
+    else {
+      return NULL;
+    }
+    if (++used > maxUsed) {
+      maxUsed = used;
+    }
+    requested += size;
+    return slot;
+  }
+  void free(void * ptr, size_t size) {
+    Slot * slot = (Slot *)ptr;
+    slot->next = freeList;
+    freeList = slot;
+    --used;
+    requested -= size;
+  }
+  void resize(size_t oldSize, size_t newSize) {
+    requested += newSize - oldSize;
+  }
+  static size_t slotSize() { return SIZE_SLOT; }
+  unsigned int capacity() const { return NUM_SLOTS; }
+  unsigned int size() const { return used; }
+  unsigned int maxSize() const { return maxUsed; }
+  uint32_t wasted() const { return used * SIZE_SLOT - requested; }
+};
+
+// The size classes, tuned from the sizes requested by the Lua scripts (the wizard ones and the tests):
+// most of them are below 16 / 32 / 64 bytes on the simulator, about half of those on the radio
+#if defined(SIMU)
+typedef PoolAllocator<16, 256> PoolAllocator_class1;
+typedef PoolAllocator<32, 384> PoolAllocator_class2;
+typedef PoolAllocator<64, 256> PoolAllocator_class3;
+typedef PoolAllocator<128, 96> PoolAllocator_class4;
+typedef PoolAllocator<256, 32> PoolAllocator_class5;
+#else
+typedef PoolAllocator<8, 128>  PoolAllocator_class1;
+typedef PoolAllocator<16, 192> PoolAllocator_class2;
+typedef PoolAllocator<32, 128> PoolAllocator_class3;
+typedef PoolAllocator<64, 32>  PoolAllocator_class4;
+typedef PoolAllocator<128, 8>  PoolAllocator_class5;
+#endif
+
+#define POOL_CLASSES   5
+
+struct PoolAllocatorStats {
+  uint32_t size[POOL_CLASSES+1];      // the slots size, 0 for the libc heap
+  uint32_t used[POOL_CLASSES+1];      // the slots used, or the bytes used in the libc heap
+  uint32_t maxUsed[POOL_CLASSES+1];   // the high-water marks
+  uint32_t capacity[POOL_CLASSES+1];
+  uint32_t wasted;                    // the bytes lost in the used slots
+  uint32_t libcAllocations;           // the allocations which did not fit in the pools
+};
+
+void poolAllocatorClear();
+void poolAllocatorGetStats(PoolAllocatorStats & stats);
+size_t poolAllocatorSize(void * ptr);
+uint32_t poolAllocatorUsed();
+uint32_t poolAllocatorMaxUsed();
+
+// wrapper for our PoolAllocator for Lua
+void * pool_l_alloc(void * ud, void * ptr, size_t osize, size_t nsize);
+
+#endif // poolallocator_h
@@ -43,6 +43,7 @@ uint8_t moduleFlag[NUM_MODULES] = { 0 };
 
 ModulePulsesData modulePulsesData[NUM_MODULES];
 TrainerPulsesData trainerPulsesData;
+LatencyStatistics pulsesLatency = { 0xFFFF, 0, 0, 0 };
 
 void setupPulses(unsigned int port)
 {
@@ -161,4 +162,15 @@ void setupPulses(unsigned int port)
     default:
       break;
   }
+
+  if (required_protocol != PROTO_NONE) {
+    pulsesLatency.add(getTmr2MHz() - channelOutputsSampleTime);
+#if defined(MIXER_SCHEDULER)
+#if defined(PCBTARANIS)
+    // the mixer is synchronized on the internal module when it sends pulses
+    if (port == INTERNAL_MODULE || s_current_protocol[INTERNAL_MODULE] != PROTO_PXX)
+#endif
+      mixerSchedulerISRTrigger();
+#endif
+  }
 }
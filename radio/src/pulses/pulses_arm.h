@@ -100,6 +100,59 @@ union TrainerPulsesData {
 extern ModulePulsesData modulePulsesData[NUM_MODULES];
 extern TrainerPulsesData trainerPulsesData;
 
+// Latency between the sampling of the sticks and the latch of the channels in a frame (in 0.5us)
+// add() is called by the pulses interrupts, the menus read and reset the values with the interrupts disabled
+struct LatencyStatistics {
+  uint16_t min;
+  uint16_t max;
+  uint64_t sum;
+  uint32_t count;
+
+  void reset()
+  {
+    __disable_irq();
+    min = 0xFFFF;
+    max = 0;
+    sum = 0;
+    count = 0;
+    __enable_irq();
+  }
+
+  LatencyStatistics snapshot() const
+  {
+    __disable_irq();
+    LatencyStatistics result = *this;
+    __enable_irq();
+    return result;
+  }
+
+  void add(uint16_t latency)
+  {
+    if (latency < min) min = latency;
+    if (latency > max) max = latency;
+    sum += latency;
+    count++;
+  }
+
+  uint16_t avg() const
+  {
+    return count ? sum / count : 0;
+  }
+};
+
+extern LatencyStatistics pulsesLatency;
+
+#if !defined(MIXER_LEAD_TIME)
+  #define MIXER_LEAD_TIME 3 // ms
+#endif
+
+uint8_t getMixerSchedulerDelay(uint16_t period);
+#if defined(MIXER_SCHEDULER)
+extern OS_FlagID mixerFlag;
+void mixerSchedulerISRTrigger();
+void mixerSchedulerWait();
+#endif
+
 void setupPulses(unsigned int port);
 void setupPulsesDSM2(unsigned int port);
 void setupPulsesPXX(unsigned int port);
@@ -58,10 +58,15 @@
 #define SCRIPTS_TELEM_PATH  SCRIPTS_PATH "/TELEM"
 
 #define MODELS_EXT          ".bin"
-#define LOGS_EXT            ".csv"
+#if defined(BINARY_LOGS)
+  #define LOGS_EXT          ".log"
+#else
+  #define LOGS_EXT          ".csv"
+#endif
 #define SOUNDS_EXT          ".wav"
 #define BITMAPS_EXT         ".bmp"
 #define SCRIPTS_EXT         ".lua"
+#define SCRIPTS_BYTECODE_EXT ".luac"
 #define TEXT_EXT            ".txt"
 #define FIRMWARE_EXT        ".bin"
 #define EEPROM_EXT          ".bin"
@@ -75,6 +80,10 @@ const pm_char *openLogs();
 void writeHeader();
 void closeLogs();
 void writeLogs();
+#if defined(BINARY_LOGS)
+extern uint16_t logsOverruns;
+void sampleLogs();
+#endif
 
 uint32_t sdGetNoSectors();
 uint32_t sdGetSize();
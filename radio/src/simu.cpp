@@ -40,6 +40,7 @@
 #include <unistd.h>
 #include "fxkeys.h"
 #include "opentx.h"
+#include "targets/simu/telemetry_replay.h"
 #include <time.h>
 #include <ctype.h>
 #if defined(SIMU_AUDIO)
@@ -340,6 +341,9 @@ long Open9xSim::onTimeout(FXObject*, FXSelector, void*)
   }
 
   per10ms();
+#if defined(CPUARM) && defined(FRSKY)
+  telemetryReplayTick();
+#endif
   refreshDisplay();
   getApp()->addTimeout(this, 2, 10);
   return 0;
@@ -451,6 +455,16 @@ int main(int argc,char **argv)
   StartAudioThread();
   StartMainThread();
 
+#if defined(CPUARM) && defined(FRSKY)
+  // simu [eeprom.bin] [sport.log] [speed]
+  if (argc >= 3) {
+    if (telemetryReplayLoad(argv[2]))
+      telemetryReplayStart(argc >= 4 ? atoi(argv[3]) : 1);
+    else
+      fprintf(stderr, "%s: no telemetry recorded\n", argv[2]);
+  }
+#endif
+
   return application.run();
 }
 
@@ -60,7 +60,36 @@ PACK(typedef struct {
 LogicalSwitchesFlightModeContext lswFm[MAX_FLIGHT_MODES];
 
 #define LS_LAST_VALUE(fm, idx) lswFm[fm].lsw[idx].lastValue
-        
+
+/*
+ * The graph lists the configured logical switches with what they read. A switch is evaluated again
+ * only when its inputs changed since its last evaluation in the same flight mode, or when its state
+ * also depends on its timers or on its last value
+ */
+#define LS_NODE_VOLATILE       0x01 // evaluated every cycle
+#define LS_NODE_SWITCHES       0x02 // v1 and v2 are switches
+#define LS_NODE_SOURCES        0x04 // v1 and v2 are sources (else only v1 is a source)
+#define LS_NODE_FM_NONE        0xff
+
+struct LogicalSwitchNode {
+  uint8_t idx;
+  uint8_t flags;
+  uint8_t fm;             // flight mode of the inputs below
+  uint8_t andsw;
+  getvalue_t inputs[2];
+};
+
+struct LogicalSwitchesGraph {
+  uint8_t count;
+  uint16_t fullEvaluation; // flight modes which need all the logical switches evaluated once
+  LogicalSwitchNode nodes[NUM_LOGICAL_SWITCH];
+};
+
+LogicalSwitchesGraph lswGraph;
+uint8_t logicalSwitchesGraphValid = 0;
+
+#define LS_GRAPH_ALL_FLIGHT_MODES ((1 << MAX_FLIGHT_MODES) - 1)
+
 #else
 
 int16_t lsLastValue[NUM_LOGICAL_SWITCH];
@@ -210,7 +239,18 @@ PACK(typedef struct {
   uint16_t duration:15;
 }) ls_stay_struct;
 
+#if defined(CPUARM)
+// When node is not NULL, its inputs have already been read by evalLogicalSwitches()
+#define LS_ANDSW_INPUT(s)         (node ? (bool)node->andsw : getSwitch(s))
+#define LS_SWITCH_INPUT(n, sw)    (node ? (bool)node->inputs[n] : getSwitch(sw))
+#define LS_SOURCE_INPUT(n, src)   (node ? node->inputs[n] : getValueForLogicalSwitch(src))
+bool getLogicalSwitch(uint8_t idx, LogicalSwitchNode * node)
+#else
+#define LS_ANDSW_INPUT(s)         getSwitch(s)
+#define LS_SWITCH_INPUT(n, sw)    getSwitch(sw)
+#define LS_SOURCE_INPUT(n, src)   getValueForLogicalSwitch(src)
 bool getLogicalSwitch(uint8_t idx)
+#endif
 {
   LogicalSwitchData * ls = lswAddress(idx);
   bool result;
@@ -224,15 +264,15 @@ bool getLogicalSwitch(uint8_t idx)
   }
 #endif
 
-  if (ls->func == LS_FUNC_NONE || (s && !getSwitch(s))) {
+  if (ls->func == LS_FUNC_NONE || (s && !LS_ANDSW_INPUT(s))) {
     if (ls->func != LS_FUNC_STICKY) {
       LS_LAST_VALUE(mixerCurrentFlightMode, idx) = CS_LAST_VALUE_INIT;
     }
     result = false;
   }
   else if ((s=lswFamily(ls->func)) == LS_FAMILY_BOOL) {
-    bool res1 = getSwitch(ls->v1);
-    bool res2 = getSwitch(ls->v2);
+    bool res1 = LS_SWITCH_INPUT(0, ls->v1);
+    bool res2 = LS_SWITCH_INPUT(1, ls->v2);
     switch (ls->func) {
       case LS_FUNC_AND:
         result = (res1 && res2);
@@ -258,10 +298,10 @@ bool getLogicalSwitch(uint8_t idx)
   }
 #endif
   else {
-    getvalue_t x = getValueForLogicalSwitch(ls->v1);
+    getvalue_t x = LS_SOURCE_INPUT(0, ls->v1);
     getvalue_t y;
     if (s == LS_FAMILY_COMP) {
-      y = getValueForLogicalSwitch(ls->v2);
+      y = LS_SOURCE_INPUT(1, ls->v2);
 
       switch (ls->func) {
         case LS_FUNC_EQUAL:
@@ -520,23 +560,147 @@ bool getSwitch(int8_t swtch)
 }
 
 #if defined(CPUARM)
+void logicalSwitchesGraphUpdate()
+{
+  lswGraph.count = 0;
+
+  for (uint8_t idx=0; idx<NUM_LOGICAL_SWITCH; idx++) {
+    LogicalSwitchData * ls = lswAddress(idx);
+    if (ls->func == LS_FUNC_NONE)
+      continue;
+
+    LogicalSwitchNode & node = lswGraph.nodes[lswGraph.count++];
+    node.idx = idx;
+    node.fm = LS_NODE_FM_NONE;
+
+    uint8_t family = lswFamily(ls->func);
+    if (family == LS_FAMILY_BOOL) {
+      node.flags = LS_NODE_SWITCHES;
+    }
+    else if (family == LS_FAMILY_COMP) {
+      node.flags = LS_NODE_SOURCES;
+    }
+    else if (family == LS_FAMILY_OFS) {
+      switch (ls->func) {
+        case LS_FUNC_VEQUAL:
+        case LS_FUNC_VALMOSTEQUAL:
+        case LS_FUNC_VPOS:
+        case LS_FUNC_VNEG:
+        case LS_FUNC_APOS:
+        case LS_FUNC_ANEG:
+          node.flags = 0;
+          break;
+        default:
+          // the other functions compare with their last value
+          node.flags = LS_NODE_VOLATILE;
+          break;
+      }
+#if defined(FRSKY)
+      if (ls->v1 >= MIXSRC_FIRST_TELEM) {
+        // depends on the telemetry streaming
+        node.flags = LS_NODE_VOLATILE;
+      }
+#endif
+    }
+    else {
+      // differences, timers, sticky and edges
+      node.flags = LS_NODE_VOLATILE;
+    }
+  }
+
+  lswGraph.fullEvaluation = LS_GRAPH_ALL_FLIGHT_MODES;
+  logicalSwitchesGraphValid = 1;
+}
+
+// Reads the inputs of a logical switch and returns true if they changed since the last call
+bool logicalSwitchInputsChanged(LogicalSwitchNode & node, LogicalSwitchData * ls)
+{
+  bool changed = (node.fm != mixerCurrentFlightMode);
+  node.fm = mixerCurrentFlightMode;
+
+  uint8_t andsw = (ls->andsw == SWSRC_NONE || getSwitch(ls->andsw));
+  if (andsw != node.andsw) {
+    node.andsw = andsw;
+    changed = true;
+  }
+
+  if (andsw) {
+    getvalue_t x, y = 0;
+    if (node.flags & LS_NODE_SWITCHES) {
+      x = getSwitch(ls->v1);
+      y = getSwitch(ls->v2);
+    }
+    else {
+      x = getValueForLogicalSwitch(ls->v1);
+      if (node.flags & LS_NODE_SOURCES)
+        y = getValueForLogicalSwitch(ls->v2);
+    }
+    if (x != node.inputs[0] || y != node.inputs[1]) {
+      node.inputs[0] = x;
+      node.inputs[1] = y;
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+void evalLogicalSwitch(uint8_t idx, LogicalSwitchNode * node, bool isCurrentPhase)
+{
+  LogicalSwitchContext &context = lswFm[mixerCurrentFlightMode].lsw[idx];
+  bool result = getLogicalSwitch(idx, node);
+  if (isCurrentPhase) {
+    if (result) {
+      if (!context.state) PLAY_LOGICAL_SWITCH_ON(idx);
+    }
+    else {
+      if (context.state) PLAY_LOGICAL_SWITCH_OFF(idx);
+    }
+  }
+  context.state = result;
+}
+
 /**
   @brief Calculates new state of logical switches for mixerCurrentFlightMode
 */
 void evalLogicalSwitches(bool isCurrentPhase)
 {
-  for (unsigned int idx=0; idx<NUM_LOGICAL_SWITCH; idx++) {
-    LogicalSwitchContext &context = lswFm[mixerCurrentFlightMode].lsw[idx];
-    bool result = getLogicalSwitch(idx);
-    if (isCurrentPhase) {
-      if (result) {
-        if (!context.state) PLAY_LOGICAL_SWITCH_ON(idx);
-      }
-      else {
-        if (context.state) PLAY_LOGICAL_SWITCH_OFF(idx);
+  if (!logicalSwitchesGraphValid) {
+    logicalSwitchesGraphUpdate();
+  }
+
+  LogicalSwitchNode * node = lswGraph.nodes;
+  LogicalSwitchNode * end = node + lswGraph.count;
+  uint16_t fmMask = (1 << mixerCurrentFlightMode);
+
+  if (lswGraph.fullEvaluation & fmMask) {
+    // all the switches (the unused ones are reset) in the same order as the incremental evaluation
+    lswGraph.fullEvaluation &= ~fmMask;
+    for (uint8_t idx=0; idx<NUM_LOGICAL_SWITCH; idx++) {
+      LogicalSwitchNode * inputs = NULL;
+      if (node != end && node->idx == idx) {
+        if (!(node->flags & LS_NODE_VOLATILE)) {
+          logicalSwitchInputsChanged(*node, lswAddress(idx));
+          inputs = node;
+        }
+        node++;
       }
+      evalLogicalSwitch(idx, inputs, isCurrentPhase);
+    }
+    return;
+  }
+
+  for (; node != end; node++) {
+    uint8_t idx = node->idx;
+    if (node->flags & LS_NODE_VOLATILE) {
+      evalLogicalSwitch(idx, NULL, isCurrentPhase);
+    }
+    else {
+      // the inputs are read even with a pending delay / duration to keep them up to date
+      bool changed = logicalSwitchInputsChanged(*node, lswAddress(idx));
+      if (changed || lswFm[mixerCurrentFlightMode].lsw[idx].timerState != SWITCH_START)
+        evalLogicalSwitch(idx, node, isCurrentPhase);
     }
-    context.state = result;
   }
 }
 #endif
@@ -860,6 +1024,7 @@ void logicalSwitchesReset()
 {
 #if defined(CPUARM)
   memset(lswFm, 0, sizeof(lswFm));
+  lswGraph.fullEvaluation = LS_GRAPH_ALL_FLIGHT_MODES;
 #else
   s_last_switch_value = 0;
 #endif
@@ -893,5 +1058,6 @@ getvalue_t convertLswTelemValue(LogicalSwitchData * ls)
 void logicalSwitchesCopyState(uint8_t src, uint8_t dst)
 {
   lswFm[dst] = lswFm[src];
+  lswGraph.fullEvaluation |= (1 << dst);
 }
 #endif
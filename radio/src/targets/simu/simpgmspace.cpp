@@ -39,7 +39,7 @@
 #include <fcntl.h>
 #include <stdarg.h>
 #include <sys/stat.h>
-#if defined(RTCLOCK)
+#if defined(RTCLOCK) || defined(CPUARM)
   #include <time.h>
 #endif
 
@@ -314,8 +314,112 @@ void *eeprom_write_function(void *)
 }
 #endif
 
+#if defined(CPUARM)
+uint16_t getTmr2MHz()
+{
+#if defined(WIN32) || !defined(__GNUC__)
+  return (uint16_t)(clock() * (2000000 / CLOCKS_PER_SEC));
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint16_t)(now.tv_sec * 2000000 + now.tv_nsec / 500);
+#endif
+}
+
+uint32_t getCycleCounter()
+{
+#if defined(WIN32) || !defined(__GNUC__)
+  return (uint32_t)(clock() * (1000000000 / CLOCKS_PER_SEC));
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)now.tv_sec * 1000000000u + (uint32_t)now.tv_nsec;
+#endif
+}
+#endif
+
+// The CoOS flags, one bit each, CoOS ticks are 2ms
+#define SIMU_MAX_FLAGS 32
+pthread_mutex_t simuFlagsMutex = PTHREAD_MUTEX_INITIALIZER;
+uint32_t simuFlags = 0;
+uint32_t simuAutoResetFlags = 0;
+uint8_t simuFlagsCount = 0;
+
+OS_FlagID simuCreateFlag(bool autoReset, bool initialState)
+{
+  pthread_mutex_lock(&simuFlagsMutex);
+  assert(simuFlagsCount < SIMU_MAX_FLAGS);
+  OS_FlagID flag = simuFlagsCount++;
+  if (autoReset)
+    simuAutoResetFlags |= (1u << flag);
+  if (initialState)
+    simuFlags |= (1u << flag);
+  pthread_mutex_unlock(&simuFlagsMutex);
+  return flag;
+}
+
+void simuSetFlag(OS_FlagID flag)
+{
+  pthread_mutex_lock(&simuFlagsMutex);
+  simuFlags |= (1u << flag);
+  pthread_mutex_unlock(&simuFlagsMutex);
+}
+
+void simuClearFlag(OS_FlagID flag)
+{
+  pthread_mutex_lock(&simuFlagsMutex);
+  simuFlags &= ~(1u << flag);
+  pthread_mutex_unlock(&simuFlagsMutex);
+}
+
+uint8_t simuWaitForSingleFlag(OS_FlagID flag, uint32_t timeout)
+{
+  for (uint32_t i=0; i<timeout*2; i++) {
+    pthread_mutex_lock(&simuFlagsMutex);
+    bool set = (simuFlags & (1u << flag));
+    if (set && (simuAutoResetFlags & (1u << flag)))
+      simuFlags &= ~(1u << flag);
+    pthread_mutex_unlock(&simuFlagsMutex);
+    if (set)
+      return E_OK;
+    sleep(1/*ms*/);
+  }
+  return E_TIMEOUT;
+}
+
 uint8_t main_thread_running = 0;
 char * main_thread_error = NULL;
+
+#if defined(CPUARM) && defined(MIXER_SCHEDULER)
+// Period of the frames of a module, as the pulses driver timers would send them (in ms)
+uint32_t simuPulsesPeriod(unsigned int port)
+{
+  switch (s_current_protocol[port]) {
+    case PROTO_PXX:
+      return 9;
+    case PROTO_PPM:
+      return 22 + g_model.moduleData[port].ppmFrameLength / 2;
+    default:
+      return 22;
+  }
+}
+
+// Builds the frames as the pulses driver interrupts would do, which triggers the mixer scheduler
+void *pulses_thread(void *)
+{
+  while (main_thread_running) {
+    unsigned int port = EXTERNAL_MODULE;
+#if defined(PCBTARANIS)
+    setupPulses(INTERNAL_MODULE);
+    if (s_current_protocol[INTERNAL_MODULE] == PROTO_PXX)
+      port = INTERNAL_MODULE;
+#endif
+    setupPulses(EXTERNAL_MODULE);
+    sleep(simuPulsesPeriod(port));
+  }
+  return NULL;
+}
+#endif
 extern void opentxStart();
 void *main_thread(void *)
 {
@@ -361,8 +465,16 @@ void *main_thread(void *)
 
     s_current_protocol[0] = 0;
 
+#if defined(CPUARM) && defined(MIXER_SCHEDULER)
+    pthread_t pulses_thread_pid;
+    pthread_create(&pulses_thread_pid, NULL, &pulses_thread, NULL);
+#endif
+
     while (main_thread_running) {
 #if defined(CPUARM)
+#if defined(MIXER_SCHEDULER)
+      mixerSchedulerWait();
+#endif
       doMixerCalculations();
 #if defined(FRSKY) || defined(MAVLINK)
       telemetryWakeup();
@@ -370,9 +482,15 @@ void *main_thread(void *)
       checkTrims();
 #endif
       perMain();
+#if !defined(CPUARM) || !defined(MIXER_SCHEDULER)
       sleep(10/*ms*/);
+#endif
     }
 
+#if defined(CPUARM) && defined(MIXER_SCHEDULER)
+    pthread_join(pulses_thread_pid, NULL);
+#endif
+
 #if defined(LUA)
     luaClose();
 #endif
@@ -409,6 +527,12 @@ void StartMainThread(bool tests)
 #if defined(CPUARM)
   pthread_mutex_init(&mixerMutex, NULL);
   pthread_mutex_init(&audioMutex, NULL);
+  // the flags of a previous run are dropped, as CoInitOS() would do
+  simuFlags = simuAutoResetFlags = 0;
+  simuFlagsCount = 0;
+#if defined(MIXER_SCHEDULER)
+  mixerFlag = CoCreateFlag(true, false);
+#endif
 #endif
 
   g_tmr10ms = 1;      // must be non-zero otherwise some SF functions (that use this timer as a marker when it was last executed) will be executed twice on startup
@@ -758,7 +882,7 @@ char *findTrueFileName(const char *path)
   return result;
 }
 
-FRESULT f_stat (const TCHAR * name, FILINFO *)
+FRESULT f_stat (const TCHAR * name, FILINFO * fno)
 {
   char *path = convertSimuPath(name);
   char * realPath = findTrueFileName(path);
@@ -769,6 +893,14 @@ FRESULT f_stat (const TCHAR * name, FILINFO *)
   }
   else {
     TRACE("f_stat(%s) = OK", path);
+    if (fno) {
+      // the FAT date and time of the file
+      struct tm * t = localtime(&tmp.st_mtime);
+      fno->fsize = tmp.st_size;
+      fno->fdate = ((t->tm_year - 80) << 9) | ((t->tm_mon + 1) << 5) | t->tm_mday;
+      fno->ftime = (t->tm_hour << 11) | (t->tm_min << 5) | (t->tm_sec / 2);
+      fno->fattrib = (S_ISDIR(tmp.st_mode) ? AM_DIR : 0);
+    }
     return FR_OK;
   }
 }
@@ -866,7 +998,11 @@ FRESULT f_readdir (DIR * rep, FILINFO * fil)
 {
   if (!rep->fs) return FR_NO_FILE;
   simu::dirent * ent = simu::readdir((simu::DIR *)rep->fs);
-  if (!ent) return FR_NO_FILE;
+  if (!ent) {
+    // the end of the directory, as FatFs gives it
+    fil->fname[0] = '\0';
+    return FR_OK;
+  }
 
 #if defined(WIN32) || !defined(__GNUC__) || defined(__APPLE__)
   fil->fattrib = (ent->d_type == DT_DIR ? AM_DIR : 0);
@@ -400,24 +400,31 @@ extern OS_MutexID audioMutex;
 #define OS_TCID uint32_t
 #define OS_STK uint32_t
 
-#define E_OK   0
-#define WDRF   0
+#define E_OK      0
+#define E_TIMEOUT 5
+#define WDRF      0
 
 #define CoInitOS(...)
 #define CoStartOS(...)
 #define CoCreateTask(...) (0)
+#define CoGetCurTaskID() (0)  // the mixer and the menus run in the same thread
 #define CoCreateMutex(...) PTHREAD_MUTEX_INITIALIZER
-#define CoSetFlag(...)
-#define CoClearFlag(...)
+OS_FlagID simuCreateFlag(bool autoReset, bool initialState);
+void simuSetFlag(OS_FlagID flag);
+void simuClearFlag(OS_FlagID flag);
+uint8_t simuWaitForSingleFlag(OS_FlagID flag, uint32_t timeout);
+#define CoSetFlag(flag) simuSetFlag(flag)
+#define isr_SetFlag(flag) simuSetFlag(flag)
+#define CoClearFlag(flag) simuClearFlag(flag)
 #define CoSetTmrCnt(...)
 #define CoEnterISR(...)
 #define CoExitISR(...)
 #define CoStartTmr(...)
-#define CoWaitForSingleFlag(...) 0
+#define CoWaitForSingleFlag(flag, timeout) simuWaitForSingleFlag(flag, timeout)
 #define CoEnterMutexSection(m) pthread_mutex_lock(&(m))
 #define CoLeaveMutexSection(m) pthread_mutex_unlock(&(m))
 #define CoTickDelay(...)
-#define CoCreateFlag(...) 0
+#define CoCreateFlag(autoReset, initialState) simuCreateFlag(autoReset, initialState)
 #define CoGetOSTime(...) 0
 inline void UART3_Configure(uint32_t baudrate, uint32_t masterClock) { }
 #define UART_Stop(...)
@@ -0,0 +1,203 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "../../opentx.h"
+#include "telemetry_replay.h"
+
+#if defined(CPUARM) && defined(FRSKY)
+
+// The bytes of one line of the recording, received at the same time
+struct TelemetryReplayChunk {
+  uint32_t time;      // in 10ms, from the start of the recording
+  uint32_t offset;    // the first byte of the chunk in replayBytes
+};
+
+static uint8_t * replayBytes = NULL;
+static uint32_t replayBytesCount = 0;
+static uint32_t replayBytesSize = 0;
+static TelemetryReplayChunk * replayChunks = NULL;
+static uint32_t replayChunksCount = 0;
+static uint32_t replayChunksSize = 0;
+
+static uint32_t replayChunk = 0;   // the next chunk to send
+static uint32_t replayTime = 0;    // the time of the recording already sent, in 10ms
+static uint16_t replaySpeed = 0;   // 0 when the replay is stopped
+
+static void replayAddByte(uint8_t data)
+{
+  if (replayBytesCount == replayBytesSize) {
+    replayBytesSize = (replayBytesSize ? 2*replayBytesSize : 4096);
+    replayBytes = (uint8_t *)realloc(replayBytes, replayBytesSize);
+  }
+  replayBytes[replayBytesCount++] = data;
+}
+
+static void replayAddChunk(uint32_t time)
+{
+  if (replayChunksCount == replayChunksSize) {
+    replayChunksSize = (replayChunksSize ? 2*replayChunksSize : 1024);
+    replayChunks = (TelemetryReplayChunk *)realloc(replayChunks, replayChunksSize*sizeof(TelemetryReplayChunk));
+  }
+  replayChunks[replayChunksCount].time = time;
+  replayChunks[replayChunksCount].offset = replayBytesCount;
+  replayChunksCount++;
+}
+
+// The lines are "2015-03-14,12:05:01.370: 7E 98 10 ...", the time has a 10ms resolution
+bool telemetryReplayLoad(const char * filename)
+{
+  telemetryReplayStop();
+  replayBytesCount = replayChunksCount = 0;
+
+  FILE * f = fopen(filename, "rb");
+  if (!f) {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char * text = (char *)malloc(size+1);
+  size = fread(text, 1, size, f);
+  fclose(f);
+  text[size] = '\0';
+
+  uint32_t start = 0, last = 0, days = 0;
+  char * line = text;
+  while (line < text + size) {
+    char * end = strchr(line, '\n');
+    if (end) {
+      *end = '\0';
+    }
+    else {
+      end = text + size;
+    }
+
+    int year, month, day, hour, minute, second, ms, pos = 0;
+    if (sscanf(line, "%d-%d-%d,%d:%d:%d.%d: %n", &year, &month, &day, &hour, &minute, &second, &ms, &pos) == 7 && pos > 0) {
+      uint32_t time = ((hour*60 + minute)*60 + second)*100 + ms/10 + days;
+      if (replayChunksCount == 0) {
+        start = time;
+      }
+      else if (time < last) {
+        // the recording went past midnight
+        days += 24*60*60*100;
+        time += 24*60*60*100;
+      }
+      last = time;
+      replayAddChunk(time - start);
+      char * p = line + pos;
+      while (true) {
+        char * next;
+        unsigned long data = strtoul(p, &next, 16);
+        if (next == p) {
+          break;
+        }
+        replayAddByte(data);
+        p = next;
+      }
+    }
+
+    line = end + 1;
+  }
+
+  free(text);
+  return replayChunksCount > 0;
+}
+
+void telemetryReplayStart(uint16_t speed)
+{
+  replayChunk = 0;
+  replayTime = 0;
+  replaySpeed = speed;
+}
+
+void telemetryReplayStop()
+{
+  replaySpeed = 0;
+}
+
+bool telemetryReplayRunning()
+{
+  return replaySpeed > 0;
+}
+
+uint32_t telemetryReplayBytes()
+{
+  return replayBytesCount;
+}
+
+uint32_t telemetryReplayDuration()
+{
+  return (replayChunksCount ? replayChunks[replayChunksCount-1].time + 1 : 0);
+}
+
+void telemetryReplayTick()
+{
+  if (!replaySpeed) {
+    return;
+  }
+
+  replayTime += replaySpeed;
+  while (replayChunk < replayChunksCount && replayChunks[replayChunk].time < replayTime) {
+    uint32_t end = (replayChunk+1 < replayChunksCount ? replayChunks[replayChunk+1].offset : replayBytesCount);
+    for (uint32_t i=replayChunks[replayChunk].offset; i<end; i++) {
+#if defined(PCBTARANIS)
+      telemetryPushByte(replayBytes[i]);
+#else
+      processSerialData(replayBytes[i]);
+#endif
+    }
+    replayChunk++;
+  }
+
+  if (replayChunk == replayChunksCount) {
+    replaySpeed = 0;
+  }
+}
+
+void telemetryReplayStep()
+{
+  if (replayTime == 0) {
+    // the protocol of the model is selected before the first bytes
+    telemetryWakeup();
+  }
+  g_tmr10ms++;
+  telemetryInterrupt10ms();
+  telemetryReplayTick();
+  telemetryWakeup();
+}
+
+#endif // #if defined(CPUARM) && defined(FRSKY)
@@ -0,0 +1,59 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef telemetry_replay_h
+#define telemetry_replay_h
+
+#include <inttypes.h>
+
+// Replays the raw telemetry bytes recorded in a sport.log (SPORT_FILE_LOG), through the same
+// reception path as the UART. The replay follows the simulated time, one telemetryReplayTick()
+// per 10ms, so that a recording gives the same results on every run, at any speed
+
+bool telemetryReplayLoad(const char * filename);
+void telemetryReplayStart(uint16_t speed=1);
+void telemetryReplayStop();
+bool telemetryReplayRunning();
+uint32_t telemetryReplayBytes();
+uint32_t telemetryReplayDuration();   // in 10ms
+
+// the bytes of the recording due at this tick, called by the simulators after per10ms()
+void telemetryReplayTick();
+
+// a 10ms period of the telemetry, without the simulator threads (tests and command line)
+void telemetryReplayStep();
+
+#endif // telemetry_replay_h
@@ -581,6 +581,7 @@ void boardInit()
 
   start_timer2() ;
   start_timer0() ;
+  cycleCounterInit() ;
   adcInit() ;
   init_pwm() ;
 
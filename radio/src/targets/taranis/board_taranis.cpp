@@ -133,6 +133,7 @@ void boardInit()
   audioInit();
   init2MhzTimer();
   init5msTimer();
+  cycleCounterInit();
   __enable_irq();
   eepromInit();
   usbInit();
@@ -36,8 +36,6 @@
 
 #include "../../opentx.h"
 
-extern Fifo<512> telemetryFifo;
-
 void telemetryPortInit(uint32_t baudrate)
 {
   if (baudrate == 0) {
@@ -134,7 +132,10 @@ extern "C" void SPORT_IRQHandler()
   while (status & (USART_FLAG_RXNE | USART_FLAG_ERRORS)) {
     data = SPORT_USART->DR;
     if (!(status & USART_FLAG_ERRORS)) {
-      telemetryFifo.push(data);
+      telemetryPushByte(data);
+    }
+    else {
+      telemetryStats.uartErrors++;
     }
     status = SPORT_USART->SR;
   }
@@ -38,7 +38,6 @@
 
 uint8_t uart3Mode = UART_MODE_NONE;
 Fifo<512> uart3TxFifo;
-extern Fifo<512> telemetryFifo;
 extern Fifo<32> sbusFifo;
 
 void uart3Setup(unsigned int baudrate)
@@ -151,13 +150,16 @@ extern "C" void USART3_IRQHandler(void)
     if (!(status & USART_FLAG_ERRORS)) {
       switch (uart3Mode) {
         case UART_MODE_TELEMETRY:
-          telemetryFifo.push(data);
+          telemetryPushByte(data);
           break;
         case UART_MODE_SBUS_TRAINER:
           sbusFifo.push(data);
           break;
       }
     }
+    else if (uart3Mode == UART_MODE_TELEMETRY) {
+      telemetryStats.uartErrors++;
+    }
 
     status = USART3->SR;
   }
@@ -121,6 +121,49 @@ uint32_t stack_free(uint32_t tid)
   return i*4;
 }
 
+#define MIXER_SCHEDULER_TICK        4000  // 2ms in 0.5us
+
+// Number of ticks to wait after a frame so that the mixer ends MIXER_LEAD_TIME before the next one
+uint8_t getMixerSchedulerDelay(uint16_t period)
+{
+  uint16_t lead = MIXER_LEAD_TIME * 2000;
+  if (period <= lead)
+    return 0;
+  return (period - lead) / MIXER_SCHEDULER_TICK;
+}
+
+#if defined(MIXER_SCHEDULER)
+#define MIXER_SCHEDULER_TIMEOUT     5     // 10ms, when no frame is sent
+
+OS_FlagID mixerFlag;
+uint16_t mixerSchedulerPeriod = 0;        // measured period of the frames (in 0.5us)
+uint16_t mixerSchedulerLastFrame = 0;
+
+// Called by the frame interrupt of the pulses driver, just after the channels have been latched
+void mixerSchedulerISRTrigger()
+{
+  uint16_t now = getTmr2MHz();
+  mixerSchedulerPeriod = now - mixerSchedulerLastFrame;
+  mixerSchedulerLastFrame = now;
+  CoEnterISR();
+  isr_SetFlag(mixerFlag);
+  CoExitISR();
+}
+
+// Waits for the next frame, then until the mixer has to run to end MIXER_LEAD_TIME before the following one
+void mixerSchedulerWait()
+{
+  if (CoWaitForSingleFlag(mixerFlag, MIXER_SCHEDULER_TIMEOUT) == E_OK) {
+    uint8_t delay = getMixerSchedulerDelay(mixerSchedulerPeriod);
+#if defined(SIMU)
+    if (delay) sleep(delay * 2/*ms*/);
+#else
+    if (delay) CoTickDelay(delay);
+#endif
+  }
+}
+#endif
+
 #if !defined(SIMU)
 
 void mixerTask(void * pdata)
@@ -129,6 +172,10 @@ void mixerTask(void * pdata)
 
   while(1) {
 
+#if defined(MIXER_SCHEDULER)
+    mixerSchedulerWait();
+#endif
+
     if (!s_pulses_paused) {
       uint16_t t0 = getTmr2MHz();
 
@@ -149,7 +196,9 @@ void mixerTask(void * pdata)
       if (t0 > maxMixerDuration) maxMixerDuration = t0 ;
     }
 
+#if !defined(MIXER_SCHEDULER)
     CoTickDelay(1);  // 2ms for now
+#endif
   }
 }
 
@@ -201,6 +250,10 @@ void tasksStart()
   debugTaskId = CoCreateTaskEx(debugTask, NULL, 10, &debugStack[DEBUG_STACK_SIZE-1], DEBUG_STACK_SIZE, 1, false);
 #endif
 
+#if defined(MIXER_SCHEDULER)
+  mixerFlag = CoCreateFlag(true, false);
+#endif
+
 #if defined(BLUETOOTH)
   btTaskId = CoCreateTask(btTask, NULL, 15, &btStack[BT_STACK_SIZE-1], BT_STACK_SIZE);
 #endif
@@ -59,10 +59,6 @@ uint8_t frskyTxBufferCount = 0;
 uint8_t telemetryState = TELEMETRY_INIT;
 #endif
 
-#if defined(PCBTARANIS)
-Fifo<512> telemetryFifo; // TODO should be in the driver
-#endif
-
 uint8_t frskyRxBufferCount = 0;
 
 FrskyData frskyData;
@@ -76,6 +72,38 @@ uint8_t telemetryProtocol = 255;
 #define IS_FRSKY_SPORT_PROTOCOL() (false)
 #endif
 
+#if defined(CPUARM)
+TelemetryStatistics telemetryStats;
+
+void TelemetryStatistics::reset()
+{
+  memclear(this, sizeof(*this));
+}
+#endif
+
+#if defined(PCBTARANIS)
+// The frames unstuffed by the UART interrupts, the ring keeps one slot free for the frame in progress
+#define TELEMETRY_FRAMES_COUNT  16
+
+struct TelemetryFrame {
+  uint8_t size;
+  uint8_t data[FRSKY_RX_PACKET_SIZE];
+};
+
+TelemetryFrame telemetryFrames[TELEMETRY_FRAMES_COUNT];
+volatile uint8_t telemetryFramesWidx = 0;
+volatile uint8_t telemetryFramesRidx = 0;
+
+// The raw bytes, for the mirror and the log, they are written outside of the interrupts
+Fifo<512> telemetryRawFifo;
+
+#if defined(SPORT_FILE_LOG) && !defined(SIMU)
+  #define TELEMETRY_RAW_SINK()  (true)
+#else
+  #define TELEMETRY_RAW_SINK()  (g_eeGeneral.uart3Mode == UART_MODE_TELEMETRY_MIRROR)
+#endif
+#endif
+
 #if defined(CPUARM)
 void FrskyValueWithMin::reset()
 {
@@ -164,12 +192,6 @@ NOINLINE void processSerialData(uint8_t data)
   btPushByte(data);
 #endif
 
-#if defined(PCBTARANIS)
-    if (g_eeGeneral.uart3Mode == UART_MODE_TELEMETRY_MIRROR) {
-      uart3Putc(data);
-    }
-#endif
-
   switch (dataState)
   {
     case STATE_DATA_START:
@@ -266,37 +288,172 @@ NOINLINE void processSerialData(uint8_t data)
 #endif
 }
 
-void telemetryWakeup()
+#if defined(PCBTARANIS)
+static uint8_t telemetryFramerState = STATE_DATA_IDLE;
+static uint8_t telemetryFramerCount = 0;   // FRSKY_RX_PACKET_SIZE+1 once the frame is too long
+
+static void telemetryFramerPush()
 {
-#if defined(CPUARM)
-  uint8_t requiredTelemetryProtocol = MODEL_TELEMETRY_PROTOCOL();
-  if (telemetryProtocol != requiredTelemetryProtocol) {
-    telemetryProtocol = requiredTelemetryProtocol;
-    telemetryInit();
+  uint8_t next = (telemetryFramesWidx + 1) & (TELEMETRY_FRAMES_COUNT - 1);
+  if (telemetryFramerCount > FRSKY_RX_PACKET_SIZE) {
+    telemetryStats.badFrames++;
+  }
+  else if (next == telemetryFramesRidx) {
+    telemetryStats.droppedFrames++;
+  }
+  else {
+    telemetryFrames[telemetryFramesWidx].size = telemetryFramerCount;
+    telemetryFramesWidx = next;
+  }
+  telemetryFramerCount = 0;
+}
+
+// Called from the UART interrupts, the same framing as processSerialData()
+void telemetryPushByte(uint8_t data)
+{
+  telemetryStats.bytes++;
+
+  if (TELEMETRY_RAW_SINK() && !telemetryRawFifo.push(data)) {
+    telemetryStats.rawDropped++;
+  }
+
+  switch (telemetryFramerState) {
+    case STATE_DATA_IDLE:
+      if (data == START_STOP) {
+        telemetryFramerCount = 0;
+        telemetryFramerState = STATE_DATA_IN_FRAME;
+      }
+      return;
+
+    case STATE_DATA_IN_FRAME:
+      if (data == START_STOP) {
+        if (telemetryFramerCount > 0) {
+          if (IS_FRSKY_SPORT_PROTOCOL()) {
+            // a S.PORT frame has a fixed size, the next one starts before its end
+            telemetryStats.badFrames++;
+            telemetryFramerCount = 0;
+          }
+          else {
+            // end of the D frame
+            telemetryFramerPush();
+          }
+        }
+        return;
+      }
+      if (data == BYTESTUFF) {
+        telemetryFramerState = STATE_DATA_XOR;
+        return;
+      }
+      break;
+
+    case STATE_DATA_XOR:
+      data ^= STUFF_MASK;
+      telemetryFramerState = STATE_DATA_IN_FRAME;
+      break;
+  }
+
+  if (telemetryFramerCount < FRSKY_RX_PACKET_SIZE) {
+    telemetryFrames[telemetryFramesWidx].data[telemetryFramerCount++] = data;
+  }
+  else {
+    telemetryFramerCount = FRSKY_RX_PACKET_SIZE + 1;
+  }
+
+#if defined(FRSKY_SPORT)
+  if (IS_FRSKY_SPORT_PROTOCOL() && telemetryFramerCount == FRSKY_SPORT_PACKET_SIZE) {
+    telemetryFramerPush();
+    telemetryFramerState = STATE_DATA_IDLE;
   }
 #endif
+}
 
-#if defined(PCBTARANIS)
+void telemetryProcessFrames()
+{
+  if (telemetryFramesRidx == telemetryFramesWidx) {
+    return;
+  }
+
+  uint32_t start = getCycleCounter();
+  do {
+    uint8_t * packet = telemetryFrames[telemetryFramesRidx].data;
+#if defined(FRSKY_SPORT)
+    if (IS_FRSKY_SPORT_PROTOCOL())
+      processSportPacket(packet);
+    else
+#endif
+      frskyDProcessPacket(packet);
+    telemetryStats.frames++;
+    telemetryFramesRidx = (telemetryFramesRidx + 1) & (TELEMETRY_FRAMES_COUNT - 1);
+  } while (telemetryFramesRidx != telemetryFramesWidx);
+
+  uint32_t duration = (getCycleCounter() - start) / CYCLES_PER_US;
+  telemetryStats.parseLast = (duration > 0xFFFF ? 0xFFFF : duration);
+  if (telemetryStats.parseLast > telemetryStats.parseMax) {
+    telemetryStats.parseMax = telemetryStats.parseLast;
+  }
+}
+
+// The mirror and the log are written here, with all the bytes received since the last call
+static void telemetryWriteRaw()
+{
   uint8_t data;
 #if defined(SPORT_FILE_LOG) && !defined(SIMU)
+  extern FIL g_telemetryFile;
   static tmr10ms_t lastTime = 0;
   tmr10ms_t newTime = get_tmr10ms();
-  struct gtm utm;
-  gettime(&utm);
+  char line[3*32];
+  uint8_t len = 0;
+  UINT written;
 #endif
-  while (telemetryFifo.pop(data)) {
-    processSerialData(data);
+
+  while (telemetryRawFifo.pop(data)) {
+    if (g_eeGeneral.uart3Mode == UART_MODE_TELEMETRY_MIRROR) {
+      uart3Putc(data);
+    }
 #if defined(SPORT_FILE_LOG) && !defined(SIMU)
-    extern FIL g_telemetryFile;
     if (lastTime != newTime) {
+      struct gtm utm;
+      gettime(&utm);
       f_printf(&g_telemetryFile, "\r\n%4d-%02d-%02d,%02d:%02d:%02d.%02d0: %02X", utm.tm_year+1900, utm.tm_mon+1, utm.tm_mday, utm.tm_hour, utm.tm_min, utm.tm_sec, g_ms100, data);
       lastTime = newTime;
     }
     else {
-      f_printf(&g_telemetryFile, " %02X", data);
+      line[len++] = ' ';
+      line[len++] = "0123456789ABCDEF"[data >> 4];
+      line[len++] = "0123456789ABCDEF"[data & 0x0F];
+      if (len == sizeof(line)) {
+        f_write(&g_telemetryFile, line, len, &written);
+        len = 0;
+      }
     }
 #endif
   }
+
+#if defined(SPORT_FILE_LOG) && !defined(SIMU)
+  if (len > 0) {
+    f_write(&g_telemetryFile, line, len, &written);
+  }
+#endif
+}
+#endif
+
+void telemetryWakeup()
+{
+#if defined(CPUARM)
+  uint8_t requiredTelemetryProtocol = MODEL_TELEMETRY_PROTOCOL();
+  if (telemetryProtocol != requiredTelemetryProtocol) {
+    telemetryProtocol = requiredTelemetryProtocol;
+    telemetryInit();
+#if defined(PCBTARANIS)
+    // the frames received with the previous protocol
+    telemetryFramesRidx = telemetryFramesWidx;
+#endif
+  }
+#endif
+
+#if defined(PCBTARANIS)
+  telemetryProcessFrames();
+  telemetryWriteRaw();
 #elif defined(PCBSKY9X)
   if (telemetryProtocol == PROTOCOL_FRSKY_D_SECONDARY) {
     uint8_t data;
@@ -324,12 +481,7 @@ void telemetryWakeup()
 #endif
 
 #if defined(CPUARM)
-  for (int i=0; i<MAX_SENSORS; i++) {
-    const TelemetrySensor & sensor = g_model.telemetrySensors[i];
-    if (sensor.type == TELEM_TYPE_CALCULATED) {
-      telemetryItems[i].eval(sensor);
-    }
-  }
+  telemetryEvalCalculated();
 #endif
 
 #if defined(VARIO)
@@ -357,6 +509,7 @@ void telemetryWakeup()
         uint8_t lastReceived = telemetryItems[i].lastReceived;
         if (lastReceived < TELEMETRY_VALUE_TIMER_CYCLE && uint8_t(now - lastReceived) > TELEMETRY_VALUE_OLD_THRESHOLD) {
           telemetryItems[i].lastReceived = TELEMETRY_VALUE_OLD;
+          telemetryItemChanged(i);
           TelemetrySensor * sensor = & g_model.telemetrySensors[i];
           if (sensor->unit == UNIT_DATETIME) {
             telemetryItems[i].datetime.datestate = 0;
@@ -486,11 +486,36 @@ void processSportPacket(uint8_t *packet);
 #if defined(PCBTARANIS)
 void sportFirmwareUpdate(ModuleIndex module, const char *filename);
 #endif
+void processSerialData(uint8_t data);
 void telemetryWakeup(void);
 void telemetryReset();
 void telemetryInit(void);
 void telemetryInterrupt10ms(void);
 
+#if defined(CPUARM)
+// The counters of the telemetry link, shown on the statistics screen
+struct TelemetryStatistics {
+  uint32_t bytes;           // the bytes received
+  uint32_t uartErrors;      // the bytes lost by the UART (overrun, noise, framing or parity errors)
+  uint32_t frames;          // the frames parsed
+  uint32_t droppedFrames;   // the frames lost because the frames ring was full
+  uint32_t badFrames;       // the frames truncated or too long
+  uint32_t crcErrors;
+  uint32_t rawDropped;      // the bytes lost by the raw sink (mirror and log)
+  uint16_t parseLast;       // the duration of the last burst of frames, in us
+  uint16_t parseMax;
+  void reset();
+};
+
+extern TelemetryStatistics telemetryStats;
+#endif
+
+#if defined(PCBTARANIS)
+// The UART interrupts delimit the frames, telemetryWakeup() parses them in bursts
+void telemetryPushByte(uint8_t data);
+void telemetryProcessFrames();
+#endif
+
 #if defined(CPUARM)
   typedef uint16_t frskyCellVoltage_t;
 #elif defined(FRSKY_HUB)
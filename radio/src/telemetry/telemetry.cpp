@@ -2,8 +2,14 @@
 
 TelemetryItem telemetryItems[MAX_SENSORS];
 
+void TelemetryItem::setChanged()
+{
+  telemetryItemChanged(this - telemetryItems);
+}
+
 void TelemetryItem::gpsReceived()
 {
+  setChanged();
   if (!distFromEarthAxis) {
     gps.extractLatitudeLongitude(&pilotLatitude, &pilotLongitude);
     uint32_t lat = pilotLatitude / 10000;
@@ -30,6 +36,8 @@ void TelemetryItem::setValue(const TelemetrySensor & sensor, int32_t val, uint32
     if (cellIndex+1 < cells.count) {
       cells.values[cellIndex+1].set(((data & 0xFFF00000) >> 20) / 5);
     }
+    // the cells sensors read the cells received so far
+    setChanged();
     if (cellIndex+2 >= cells.count) {
       newVal = 0;
       for (int i=0; i<count; i++) {
@@ -227,6 +235,10 @@ void TelemetryItem::setValue(const TelemetrySensor & sensor, int32_t val, uint32
     }
   }
 
+  // the same value received again in the same 100ms is not a change
+  if (newVal != value || lastReceived != now()) {
+    setChanged();
+  }
   value = newVal;
   lastReceived = now();
 }
@@ -266,6 +278,9 @@ void TelemetryItem::per10ms(const TelemetrySensor & sensor)
           currentItem.consumption.prescale -= 3600;
           setValue(sensor, value+1, sensor.unit, sensor.prec);
         }
+        if (lastReceived != now()) {
+          setChanged();
+        }
         lastReceived = now();
       }
       break;
@@ -325,7 +340,7 @@ void TelemetryItem::eval(const TelemetrySensor & sensor)
 
     case TELEM_FORMULA_DIST:
       if (sensor.dist.gps) {
-        TelemetryItem gpsItem = telemetryItems[sensor.dist.gps-1];
+        TelemetryItem & gpsItem = telemetryItems[sensor.dist.gps-1];
         TelemetryItem * altItem = NULL;
         if (!gpsItem.isAvailable()) {
           return;
@@ -448,6 +463,8 @@ void delTelemetryIndex(uint8_t index)
 {
   memclear(&g_model.telemetrySensors[index], sizeof(TelemetrySensor));
   telemetryItems[index].clear();
+  telemetryRoutesInvalidate();
+  telemetryCalcGraphInvalidate();
   eeDirty(EE_MODEL);
 }
 
@@ -479,21 +496,63 @@ bool isSensorAvailableInResetSpecialFunction(int index)
     return telemetrySensor.isAvailable();
 }
 
-void setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t instance, int32_t value, uint32_t unit, uint32_t prec)
+// The routes from the ids and instances received to the sensors, in a hash table with open addressing.
+// The sensors with the same id and instance are chained in telemetryRoutesNext[], in the sensors order
+TelemetryRoute telemetryRoutes[TELEMETRY_ROUTES_SIZE];
+int8_t telemetryRoutesNext[MAX_SENSORS];
+bool telemetryRoutesValid = false;
+
+static TelemetryRoute * telemetryRouteFind(uint16_t id, uint8_t instance)
 {
-  bool available = false;
-  
-  for (int index=0; index<MAX_SENSORS; index++) {
+  // there are less sensors than routes, a free route is always found
+  uint32_t key = (id << 8) + instance;
+  unsigned int i = (key * 2654435769u) >> (32 - TELEMETRY_ROUTES_BITS);
+  while (1) {
+    TelemetryRoute & route = telemetryRoutes[i];
+    if (route.sensor < 0 || (route.id == id && route.instance == instance)) {
+      return &route;
+    }
+    i = (i + 1) & (TELEMETRY_ROUTES_SIZE - 1);
+  }
+}
+
+void telemetryRoutesLoad()
+{
+  // set before, an invalidation from another task while loading is not lost
+  telemetryRoutesValid = true;
+
+  for (int i=0; i<TELEMETRY_ROUTES_SIZE; i++) {
+    telemetryRoutes[i].sensor = -1;
+  }
+
+  // the calculated sensors use the id and the instance for something else
+  for (int index=MAX_SENSORS-1; index>=0; index--) {
     TelemetrySensor & telemetrySensor = g_model.telemetrySensors[index];
-    if (telemetrySensor.id == id && telemetrySensor.instance == instance) {
-      telemetryItems[index].setValue(g_model.telemetrySensors[index], value, unit, prec);
-      available = true;
+    if (telemetrySensor.type == TELEM_TYPE_CUSTOM && telemetrySensor.isAvailable()) {
+      TelemetryRoute * route = telemetryRouteFind(telemetrySensor.id, telemetrySensor.instance);
+      telemetryRoutesNext[index] = route->sensor;
+      route->id = telemetrySensor.id;
+      route->instance = telemetrySensor.instance;
+      route->sensor = index;
     }
   }
-  
-  if (!available) {
+}
+
+void setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t instance, int32_t value, uint32_t unit, uint32_t prec)
+{
+  if (!telemetryRoutesValid) {
+    telemetryRoutesLoad();
+  }
+
+  const TelemetryRoute * route = telemetryRouteFind(id, instance);
+  for (int index=route->sensor; index>=0; index=telemetryRoutesNext[index]) {
+    telemetryItems[index].setValue(g_model.telemetrySensors[index], value, unit, prec);
+  }
+
+  if (route->sensor < 0) {
     int index = availableTelemetryIndex();
     if (index >= 0) {
+      telemetryRoutesInvalidate();
       switch (protocol) {
 #if defined(FRSKY_SPORT)
         case TELEM_PROTO_FRSKY_SPORT:
@@ -614,3 +673,129 @@ bool TelemetrySensor::isConfigurable()
   }
   return true;
 }
+
+#if MAX_SENSORS > 32
+  #error "The telemetry items masks are 32 bits"
+#endif
+
+// The sensors read by each calculated sensor, and the calculated sensors sorted so that a sensor comes
+// after the calculated sensors it reads: a change goes through a chain of calculated sensors at once
+uint32_t telemetryItemsChanged = 0;
+uint32_t telemetryCalcSources[MAX_SENSORS];
+int8_t telemetryCalcOrder[MAX_SENSORS];
+uint8_t telemetryCalcCount = 0;
+bool telemetryCalcGraphValid = false;
+
+static uint32_t telemetryCalcGetSources(const TelemetrySensor & sensor)
+{
+  uint32_t sources = 0;
+  switch (sensor.formula) {
+    case TELEM_FORMULA_CELL:
+      if (sensor.cell.source)
+        sources = TELEMETRY_ITEM_MASK(sensor.cell.source-1);
+      break;
+
+    case TELEM_FORMULA_DIST:
+      if (sensor.dist.gps) {
+        sources = TELEMETRY_ITEM_MASK(sensor.dist.gps-1);
+        if (sensor.dist.alt)
+          sources |= TELEMETRY_ITEM_MASK(sensor.dist.alt-1);
+      }
+      break;
+
+    case TELEM_FORMULA_ADD:
+    case TELEM_FORMULA_AVERAGE:
+    case TELEM_FORMULA_MIN:
+    case TELEM_FORMULA_MAX:
+    case TELEM_FORMULA_MULTIPLY:
+      for (int i=0; i<4; i++) {
+        int8_t source = sensor.calc.sources[i];
+        if (source)
+          sources |= TELEMETRY_ITEM_MASK(abs(source)-1);
+      }
+      // without any source the value is set at each evaluation
+      if (!sources)
+        sources = (uint32_t)-1;
+      break;
+
+    default:
+      // the totalized sensors follow their source in setValue(), the consumption ones in per10ms()
+      break;
+  }
+  return sources;
+}
+
+void telemetryCalcGraphLoad()
+{
+  telemetryCalcGraphValid = true;
+  telemetryCalcCount = 0;
+
+  uint32_t pending = 0;
+  for (int index=0; index<MAX_SENSORS; index++) {
+    const TelemetrySensor & sensor = g_model.telemetrySensors[index];
+    telemetryCalcSources[index] = (sensor.type == TELEM_TYPE_CALCULATED ? telemetryCalcGetSources(sensor) : 0);
+    if (telemetryCalcSources[index]) {
+      pending |= TELEMETRY_ITEM_MASK(index);
+    }
+  }
+
+  while (pending) {
+    uint32_t ready = 0;
+    for (int index=0; index<MAX_SENSORS; index++) {
+      uint32_t mask = TELEMETRY_ITEM_MASK(index);
+      if ((pending & mask) && !(telemetryCalcSources[index] & pending & ~mask)) {
+        ready |= mask;
+      }
+    }
+    if (!ready) {
+      // the sensors left read each other, they keep the sensors order
+      ready = pending;
+    }
+    for (int index=0; index<MAX_SENSORS; index++) {
+      if (ready & TELEMETRY_ITEM_MASK(index)) {
+        telemetryCalcOrder[telemetryCalcCount++] = index;
+      }
+    }
+    pending &= ~ready;
+  }
+
+  // all the calculated sensors are evaluated once with the new graph
+  telemetryItemsChanged = (uint32_t)-1;
+}
+
+void telemetryEvalCalculated()
+{
+  if (!telemetryCalcGraphValid) {
+    telemetryCalcGraphLoad();
+  }
+
+  // the changes are consumed with the interrupts disabled, as per10ms() changes the consumption sensors
+  __disable_irq();
+  uint32_t changed = telemetryItemsChanged;
+  telemetryItemsChanged = 0;
+  __enable_irq();
+
+  uint32_t evaluated = 0;
+  for (int i=0; i<telemetryCalcCount; i++) {
+    int index = telemetryCalcOrder[i];
+    if (telemetryCalcSources[index] & changed) {
+      uint32_t mask = TELEMETRY_ITEM_MASK(index);
+      TelemetryItem & item = telemetryItems[index];
+      uint8_t lastReceived = item.lastReceived;
+      item.eval(g_model.telemetrySensors[index]);
+      if (item.lastReceived != lastReceived) {
+        // the sensor became old
+        item.setChanged();
+      }
+      // the calculated sensors reading this one come after it in the order
+      if (telemetryItemsChanged & mask) {
+        changed |= mask;
+        evaluated |= mask;
+      }
+    }
+  }
+
+  __disable_irq();
+  telemetryItemsChanged &= ~evaluated;
+  __enable_irq();
+}
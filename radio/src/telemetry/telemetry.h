@@ -156,6 +156,7 @@ class TelemetryItem
 
     void eval(const TelemetrySensor & sensor);
     void per10ms(const TelemetrySensor & sensor);
+    void setChanged();
 
     void setValue(const TelemetrySensor & sensor, int32_t newVal, uint32_t unit, uint32_t prec=0);
     bool isAvailable();
@@ -184,6 +185,33 @@ inline bool isTelemetryFieldComparisonAvailable(int index)
 
 extern TelemetryItem telemetryItems[];
 
+// The sensors which receive the values of an id and an instance
+#define TELEMETRY_ROUTES_BITS  6
+#define TELEMETRY_ROUTES_SIZE  (1 << TELEMETRY_ROUTES_BITS)
+struct TelemetryRoute {
+  uint16_t id;
+  uint8_t instance;
+  int8_t sensor;      // the first sensor, -1 when the route is free
+};
+extern bool telemetryRoutesValid;
+void telemetryRoutesLoad();
+inline void telemetryRoutesInvalidate() { telemetryRoutesValid = false; }
+
+// The calculated sensors, in the order of their sources, are evaluated when one of their sources changed
+#define TELEMETRY_ITEM_MASK(index)  ((uint32_t)1 << (index))
+extern uint32_t telemetryItemsChanged;
+extern bool telemetryCalcGraphValid;
+void telemetryCalcGraphLoad();
+inline void telemetryCalcGraphInvalidate() { telemetryCalcGraphValid = false; }
+inline void telemetryItemChanged(int index)
+{
+  // the consumption sensors are changed in the per10ms() interrupt
+  __disable_irq();
+  telemetryItemsChanged |= TELEMETRY_ITEM_MASK(index);
+  __enable_irq();
+}
+void telemetryEvalCalculated();
+
 void setTelemetryValue(TelemetryProtocol protocol, uint16_t id, uint8_t instance, int32_t value, uint32_t unit, uint32_t prec);
 void delTelemetryIndex(uint8_t index);
 int availableTelemetryIndex();
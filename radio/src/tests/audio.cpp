@@ -0,0 +1,516 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "gtests.h"
+
+#if defined(CPUARM)
+#if defined(SIMU_AUDIO)
+  #define AUDIO_SILENCE  0x8000
+  #define TONE_PEAK(x)   (x)
+#else
+  #define AUDIO_SILENCE  (0x8000 >> 4)
+  #define TONE_PEAK(x)   ((x) >> 4)
+#endif
+
+struct ToneStats {
+  int risingEdges;
+  int peak;
+  int last; // the index of the last sample which is not silent
+};
+
+int previousSample = 0;
+
+template <class T>
+int mixContext(T & context, int32_t gain, AudioBuffer & buffer)
+{
+  AudioMixBuffer mix;
+  mix.clear();
+  int result = context.mixBuffer(&mix, gain);
+  mix.convert(&buffer, AUDIO_BUFFER_SIZE);
+  return result;
+}
+
+ToneStats mixTone(ToneContext & context, int & result, int volume=0)
+{
+  AudioBuffer buffer;
+  result = mixContext(context, getToneVolumeGain(volume), buffer);
+
+  ToneStats stats = { 0, 0, -1 };
+  for (int i=0; i<AUDIO_BUFFER_SIZE; i++) {
+    int sample = buffer.data[i] - AUDIO_SILENCE;
+    if (previousSample <= 0 && sample > 0)
+      stats.risingEdges++;
+    previousSample = sample;
+    if (sample > stats.peak)
+      stats.peak = sample;
+    if (sample != 0)
+      stats.last = i;
+  }
+  return stats;
+}
+
+void setTone(ToneContext & context, uint16_t freq, uint16_t duration, int8_t freqIncr=0)
+{
+  AudioFragment fragment;
+  fragment.clear();
+  fragment.type = FRAGMENT_TONE;
+  fragment.tone.freq = freq;
+  fragment.tone.duration = duration;
+  fragment.tone.freqIncr = freqIncr;
+  context.setFragment(fragment);
+  previousSample = 0;
+}
+
+TEST(Audio, ToneFrequency)
+{
+  ToneContext context;
+  setTone(context, 1000, 100);
+  int edges = 0;
+  int result;
+  for (int i=0; i<10; i++) {
+    ToneStats stats = mixTone(context, result);
+    EXPECT_EQ(stats.last, AUDIO_BUFFER_SIZE-1);
+    EXPECT_NEAR(stats.peak, TONE_PEAK(16000/6), 1);
+    edges += stats.risingEdges;
+  }
+  EXPECT_EQ(result, 0);
+  EXPECT_NEAR(edges, 100, 1);
+}
+
+TEST(Audio, ToneVolume)
+{
+  ToneContext context;
+  int result;
+  setTone(context, 1000, 100);
+  EXPECT_NEAR(mixTone(context, result, 2).peak, TONE_PEAK(16000/2), 1);
+  setTone(context, 1000, 100);
+  EXPECT_NEAR(mixTone(context, result, -2).peak, TONE_PEAK(16000/10), 1);
+  // the low frequencies are louder
+  setTone(context, 165, 100);
+  EXPECT_NEAR(mixTone(context, result, 0).peak, TONE_PEAK(16000*4/6), 2);
+}
+
+TEST(Audio, ToneEndsWithPeriod)
+{
+  ToneContext context;
+  int result;
+  setTone(context, 730, 15);
+  mixTone(context, result);
+  ToneStats stats = mixTone(context, result);
+  // 3.65 periods would fit in the remaining 5ms, the tone stops after 2.7 periods
+  EXPECT_NEAR(stats.last, 118, 1);
+  EXPECT_EQ(stats.risingEdges, 2);
+}
+
+TEST(Audio, ToneSweep)
+{
+  ToneContext context;
+  int result;
+  setTone(context, 1000, 100, 10);
+  for (int i=0; i<10; i++) {
+    // +100Hz each 10ms buffer
+    EXPECT_NEAR(mixTone(context, result).risingEdges, 10+i, 1);
+  }
+}
+
+TEST(Audio, MixerSaturation)
+{
+  // 2 loud low frequency tones in phase are clipped once, when the buffer is converted
+  ToneContext context1, context2;
+  setTone(context1, 100, 100);
+  setTone(context2, 100, 100);
+  AudioMixBuffer mix;
+  mix.clear();
+  context1.mixBuffer(&mix, getToneVolumeGain(2));
+  context2.mixBuffer(&mix, getToneVolumeGain(2));
+  AudioBuffer buffer;
+  mix.convert(&buffer, AUDIO_BUFFER_SIZE);
+  int top = 0, bottom = 0;
+  for (int i=0; i<AUDIO_BUFFER_SIZE; i++) {
+    EXPECT_EQ(buffer.data[i], limit<int32_t>(0, AUDIO_SILENCE + TONE_PEAK(mix.data[i]), 2*AUDIO_SILENCE-1)) << i;
+    if (buffer.data[i] == 2*AUDIO_SILENCE-1)
+      top++;
+    else if (buffer.data[i] == 0)
+      bottom++;
+  }
+  EXPECT_GT(top, 0);
+  EXPECT_GT(bottom, 0);
+}
+
+#if defined(SDCARD)
+void writeWavFile(const char * path, uint32_t freq, uint16_t toneFreq, uint32_t count)
+{
+  FILE * f = fopen(path, "wb");
+  uint32_t fmt[] = { 16, 1 + (1 << 16), freq, freq*2, 2 + (16 << 16) };
+  uint32_t size = 2*count;
+  uint32_t riffSize = 4 + 8 + sizeof(fmt) - 4 + 8 + size;
+  fwrite("RIFF", 1, 4, f);
+  fwrite(&riffSize, 4, 1, f);
+  fwrite("WAVEfmt ", 1, 8, f);
+  fwrite(fmt, sizeof(fmt), 1, f);
+  fwrite("data", 1, 4, f);
+  fwrite(&size, 4, 1, f);
+  for (uint32_t i=0; i<count; i++) {
+    int16_t sample = 16000 * sin(2*M_PI*toneFreq*i/freq);
+    fwrite(&sample, 2, 1, f);
+  }
+  fclose(f);
+}
+
+TEST(Audio, WavResampling)
+{
+  char sdDirectory[sizeof(simuSdDirectory)];
+  strcpy(sdDirectory, simuSdDirectory);
+  char tmpDirectory[] = "/tmp/opentx-gtests-XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpDirectory) != NULL);
+  strcpy(simuSdDirectory, tmpDirectory);
+  char path[sizeof(tmpDirectory)+16];
+
+  static WavContext context;
+  const uint32_t rates[] = { 8000, 16000, 22050, 32000, 44100, 48000 };
+  for (unsigned int r=0; r<DIM(rates); r++) {
+    // 100ms of a 1kHz tone, a new file name each time as the small files are cached
+    sprintf(path, "%s/test%d.wav", tmpDirectory, rates[r]);
+    writeWavFile(path, rates[r], 1000, rates[r]/10);
+    context.fragment.clear();
+    context.fragment.type = FRAGMENT_FILE;
+    strcpy(context.fragment.file, path+strlen(tmpDirectory));
+    wavUnderruns = 0;
+    previousSample = 0;
+
+    int total = 0, edges = 0, peak = 0;
+    while (context.fragment.type == FRAGMENT_FILE) {
+      AudioBuffer buffer;
+      int result = mixContext(context, getWavVolumeGain(2), buffer);
+      ASSERT_GE(result, 0);
+      for (int i=0; i<result; i++) {
+        int sample = buffer.data[i] - AUDIO_SILENCE;
+        if (previousSample <= 0 && sample > 0)
+          edges++;
+        if (sample > peak)
+          peak = sample;
+        previousSample = sample;
+      }
+      total += result;
+    }
+    // the output stops on the last input sample
+    EXPECT_NEAR(total, AUDIO_SAMPLE_RATE/10, AUDIO_SAMPLE_RATE/rates[r]+1) << rates[r] << "Hz";
+    EXPECT_NEAR(edges, 100, 1) << rates[r] << "Hz";
+    EXPECT_NEAR(peak, TONE_PEAK(16000), TONE_PEAK(16000)/20) << rates[r] << "Hz";
+    EXPECT_EQ(wavUnderruns, 0);
+    unlink(path);
+  }
+
+  rmdir(tmpDirectory);
+  strcpy(simuSdDirectory, sdDirectory);
+}
+
+void touchFile(const char * directory, const char * name, bool remove=false)
+{
+  char path[1024];
+  sprintf(path, "%s/%s", directory, name);
+  if (remove)
+    unlink(path);
+  else
+    fclose(fopen(path, "wb"));
+}
+
+TEST(Audio, Catalog)
+{
+  char sdDirectory[sizeof(simuSdDirectory)];
+  strcpy(sdDirectory, simuSdDirectory);
+  char tmpDirectory[] = "/tmp/opentx-gtests-XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpDirectory) != NULL);
+  strcpy(simuSdDirectory, tmpDirectory);
+  char path[sizeof(tmpDirectory)+16];
+  sprintf(path, "%s/SOUNDS", tmpDirectory);
+  mkdir(path, 0755);
+  touchFile(path, "tada.wav");
+  touchFile(path, "FM1-ON.WAV");
+  touchFile(path, "0028.wav");
+  touchFile(path, "readme.txt");
+  sprintf(path, "%s/SOUNDS/dir.wav", tmpDirectory);
+  mkdir(path, 0755);
+
+  static AudioCatalog catalog;
+  catalog.load("/SOUNDS");
+  EXPECT_EQ(catalog.count, 3);
+  EXPECT_TRUE(catalog.contains("tada.wav"));
+  EXPECT_TRUE(catalog.contains("TADA.wav"));
+  EXPECT_TRUE(catalog.contains("fm1-on.wav"));
+  EXPECT_FALSE(catalog.contains("fm1-off.wav"));
+  EXPECT_FALSE(catalog.contains("readme.txt"));
+  EXPECT_FALSE(catalog.contains("dir.wav"));
+  // 0292.wav and 0028.wav would collide with 16bit hashes
+  EXPECT_TRUE(catalog.contains("0028.wav"));
+  EXPECT_FALSE(catalog.contains("0292.wav"));
+
+  // the files of the directories which are not in the catalogs are tried
+  modelAudioCatalog = catalog;
+  EXPECT_TRUE(isAudioFileAvailable("/SOUNDS/tada.wav"));
+  EXPECT_FALSE(isAudioFileAvailable("/SOUNDS/bye.wav"));
+  EXPECT_TRUE(isAudioFileAvailable("/SOUNDS/en/bye.wav"));
+  modelAudioCatalog.clear();
+
+  // a directory which can't be scanned, the files are looked for on the SD card
+  catalog.load("/SOUNDS/missing");
+  EXPECT_FALSE(catalog.complete);
+  EXPECT_FALSE(catalog.contains("tada.wav"));
+
+  // when there are too many files, they are looked for on the SD card
+  char name[16];
+  for (int i=0; i<AUDIO_CATALOG_SLOTS; i++) {
+    sprintf(name, "%04d.wav", i);
+    touchFile(path, name);
+  }
+  catalog.load(path+strlen(tmpDirectory));
+  EXPECT_FALSE(catalog.complete);
+  EXPECT_FALSE(catalog.contains("missing.wav"));
+  EXPECT_TRUE(catalog.contains("0511.wav"));
+  EXPECT_TRUE(catalog.contains("0000.WAV"));
+  for (int i=0; i<AUDIO_CATALOG_SLOTS; i++) {
+    sprintf(name, "%04d.wav", i);
+    touchFile(path, name, true);
+  }
+
+  rmdir(path);
+  sprintf(path, "%s/SOUNDS", tmpDirectory);
+  touchFile(path, "tada.wav", true);
+  touchFile(path, "FM1-ON.WAV", true);
+  touchFile(path, "0028.wav", true);
+  touchFile(path, "readme.txt", true);
+  rmdir(path);
+  rmdir(tmpDirectory);
+  strcpy(simuSdDirectory, sdDirectory);
+}
+
+class TestAudioQueue : public AudioQueue {
+  public:
+    using AudioQueue::wakeup;
+    using AudioQueue::normalContext;
+    using AudioQueue::priorityContext;
+    using AudioQueue::varioContext;
+    using AudioQueue::ducking;
+};
+
+void setWavFile(WavContext & context, const char * file)
+{
+  context.fragment.clear();
+  context.fragment.type = FRAGMENT_FILE;
+  strcpy(context.fragment.file, file);
+}
+
+TEST(Audio, Mixer)
+{
+  char sdDirectory[sizeof(simuSdDirectory)];
+  strcpy(sdDirectory, simuSdDirectory);
+  char tmpDirectory[] = "/tmp/opentx-gtests-XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpDirectory) != NULL);
+  strcpy(simuSdDirectory, tmpDirectory);
+  char path[sizeof(tmpDirectory)+16];
+  sprintf(path, "%s/voice.wav", tmpDirectory);
+  // 100ms of voice
+  writeWavFile(path, 16000, 500, 1600);
+
+  g_eeGeneral.beepVolume = 0;
+  g_eeGeneral.wavVolume = 0;
+  g_eeGeneral.varioVolume = 1;
+
+  // a beep, a voice prompt and the vario, which is ducked during the prompt
+  static TestAudioQueue queue;
+  static ToneContext priority, vario;
+  static WavContext voice;
+  setTone(queue.priorityContext, 2000, 30);
+  setTone(priority, 2000, 30);
+  setWavFile(queue.normalContext.wav, "/voice.wav");
+  setWavFile(voice, "/voice.wav");
+  setTone(queue.varioContext, 700, 300);
+  setTone(vario, 700, 300);
+
+  int32_t minDucking = AUDIO_GAIN_UNITY;
+  for (int i=0; i<20; i++) {
+    queue.wakeup();
+    AudioBuffer * buffer = queue.getNextFilledBuffer();
+    ASSERT_TRUE(buffer != NULL) << i;
+    EXPECT_EQ(buffer->size, AUDIO_BUFFER_SIZE);
+
+    if (i < 10) {
+      EXPECT_EQ(queue.ducking, max<int32_t>(AUDIO_GAIN_UNITY-(i+1)*AUDIO_DUCKING_STEP, AUDIO_DUCKING_GAIN)) << i;
+    }
+    minDucking = min(minDucking, queue.ducking);
+
+    // the reference, each context mixed on its own
+    AudioMixBuffer mix;
+    mix.clear();
+    priority.mixBuffer(&mix, getToneVolumeGain(0));
+    if (voice.fragment.type == FRAGMENT_FILE)
+      voice.mixBuffer(&mix, getWavVolumeGain(0));
+    vario.mixBuffer(&mix, (getToneVolumeGain(1) * queue.ducking) >> AUDIO_GAIN_SHIFT);
+    AudioBuffer reference;
+    mix.convert(&reference, AUDIO_BUFFER_SIZE);
+    EXPECT_EQ(memcmp(buffer->data, reference.data, sizeof(reference.data)), 0) << i;
+  }
+  EXPECT_EQ(minDucking, AUDIO_DUCKING_GAIN);
+  // the vario is back to its volume after the prompt
+  EXPECT_EQ(queue.ducking, AUDIO_GAIN_UNITY);
+
+  unlink(path);
+  rmdir(tmpDirectory);
+  strcpy(simuSdDirectory, sdDirectory);
+}
+
+#if defined(AUDIO_CACHE_SIZE)
+int playWavFile(WavContext & context, const char * file, uint16_t * output, int size)
+{
+  setWavFile(context, file);
+
+  int total = 0;
+  while (context.fragment.type == FRAGMENT_FILE && total+AUDIO_BUFFER_SIZE <= size) {
+    AudioBuffer buffer;
+    int result = mixContext(context, getWavVolumeGain(2), buffer);
+    if (result < 0)
+      return result;
+    memcpy(&output[total], buffer.data, result*sizeof(uint16_t));
+    total += result;
+  }
+  return total;
+}
+
+int countRisingEdges(const uint16_t * output, int size)
+{
+  int edges = 0;
+  for (int i=1; i<size; i++) {
+    if (output[i-1] <= AUDIO_SILENCE && output[i] > AUDIO_SILENCE)
+      edges++;
+  }
+  return edges;
+}
+
+TEST(Audio, Cache)
+{
+  char sdDirectory[sizeof(simuSdDirectory)];
+  strcpy(sdDirectory, simuSdDirectory);
+  char tmpDirectory[] = "/tmp/opentx-gtests-XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpDirectory) != NULL);
+  strcpy(simuSdDirectory, tmpDirectory);
+
+  // the SOUNDS/<language>/SYSTEM directory with the number prompts, the last one does not fit in a slot
+  char systemDirectory[AUDIO_FILENAME_MAXLEN+1];
+  strcpy(getAudioPath(systemDirectory), SYSTEM_SUBDIR);
+  char file[sizeof(systemDirectory)+sizeof("/0000.wav")];
+  char path[sizeof(tmpDirectory)+sizeof(file)];
+  for (unsigned int i=1; i<=strlen(systemDirectory); i++) {
+    if (systemDirectory[i] == '/' || systemDirectory[i] == '\0') {
+      snprintf(path, sizeof(path), "%s%.*s", tmpDirectory, i, systemDirectory);
+      mkdir(path, 0755);
+    }
+  }
+  const unsigned int prompts = AUDIO_CACHE_SLOTS+2;
+  const uint32_t samples = AUDIO_CACHE_SLOT_SIZE/2;
+  for (unsigned int i=0; i<prompts; i++) {
+    snprintf(path, sizeof(path), "%s%s/%04u.wav", tmpDirectory, systemDirectory, i);
+    writeWavFile(path, 8000, 500, i==prompts-1 ? samples+1 : samples);
+  }
+
+  // the number prompts are loaded in the free entries
+  memset(&audioCache, 0, sizeof(audioCache));
+  referenceSystemAudioFiles();
+  EXPECT_TRUE(audioCache.prefillRequested);
+  audioCache.prefill();
+  EXPECT_FALSE(audioCache.prefillRequested);
+  for (unsigned int i=0; i<AUDIO_CACHE_SLOTS; i++) {
+    snprintf(file, sizeof(file), "%s/%04u.wav", systemDirectory, i);
+    EXPECT_STREQ(audioCache.entries[i].file, file);
+    EXPECT_EQ(audioCache.entries[i].size, uint32_t(AUDIO_CACHE_SLOT_SIZE));
+  }
+
+  // a cached prompt is played from the RAM, the file is not needed anymore
+  static WavContext context;
+  static uint16_t reference[AUDIO_SAMPLE_RATE], output[AUDIO_SAMPLE_RATE];
+  snprintf(file, sizeof(file), "%s/0000.wav", systemDirectory);
+  int size = playWavFile(context, file, reference, DIM(reference));
+  EXPECT_NEAR(size, AUDIO_SAMPLE_RATE*samples/8000, AUDIO_SAMPLE_RATE/8000+1);
+  EXPECT_NEAR(countRisingEdges(reference, size), 500*samples/8000, 1);
+  EXPECT_EQ(audioCache.hits, 1);
+  snprintf(path, sizeof(path), "%s%s", tmpDirectory, file);
+  unlink(path);
+  EXPECT_EQ(playWavFile(context, file, output, DIM(output)), size);
+  EXPECT_EQ(memcmp(reference, output, size*sizeof(uint16_t)), 0);
+  EXPECT_EQ(audioCache.hits, 2);
+  EXPECT_EQ(audioCache.misses, 0);
+
+  // a prompt read from the file takes the least recently used entry
+  snprintf(file, sizeof(file), "%s/%04d.wav", systemDirectory, AUDIO_CACHE_SLOTS);
+  EXPECT_EQ(playWavFile(context, file, output, DIM(output)), size);
+  EXPECT_EQ(memcmp(reference, output, size*sizeof(uint16_t)), 0);
+  EXPECT_EQ(audioCache.misses, 1);
+  EXPECT_STREQ(audioCache.entries[1].file, file);
+  EXPECT_EQ(playWavFile(context, file, output, DIM(output)), size);
+  EXPECT_EQ(audioCache.hits, 3);
+  snprintf(file, sizeof(file), "%s/0000.wav", systemDirectory);
+  EXPECT_STREQ(audioCache.entries[0].file, file);
+
+  // a prompt which does not fit in a slot is always read from the file
+  snprintf(file, sizeof(file), "%s/%04u.wav", systemDirectory, prompts-1);
+  EXPECT_GT(playWavFile(context, file, output, DIM(output)), size);
+  EXPECT_GT(playWavFile(context, file, output, DIM(output)), size);
+  EXPECT_EQ(audioCache.misses, 3);
+  for (unsigned int i=0; i<AUDIO_CACHE_SLOTS; i++) {
+    EXPECT_STRNE(audioCache.entries[i].file, file);
+  }
+
+  memset(&audioCache, 0, sizeof(audioCache));
+  soundsAudioCatalog.clear();
+  systemAudioCatalog.clear();
+  for (unsigned int i=1; i<prompts; i++) {
+    snprintf(path, sizeof(path), "%s%s/%04u.wav", tmpDirectory, systemDirectory, i);
+    unlink(path);
+  }
+  for (int i=strlen(systemDirectory); i>0; i--) {
+    if (systemDirectory[i] == '/' || systemDirectory[i] == '\0') {
+      snprintf(path, sizeof(path), "%s%.*s", tmpDirectory, i, systemDirectory);
+      rmdir(path);
+    }
+  }
+  rmdir(tmpDirectory);
+  strcpy(simuSdDirectory, sdDirectory);
+}
+#endif
+#endif
+#endif
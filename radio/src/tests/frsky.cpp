@@ -35,6 +35,7 @@
  */
 
 #include "gtests.h"
+#include "../targets/simu/telemetry_replay.h"
 
 #if defined(FRSKY) && !defined(CPUARM)
 extern void frskyDProcessPacket(uint8_t *packet);
@@ -435,6 +436,315 @@ TEST(FrSkySPORT, frskyCurrent)
 }
 #endif
 
+struct SportFrame {
+  uint8_t physicalId;
+  uint16_t appId;
+  uint32_t data;
+};
+
+// The frames of a receiver with a vario, a FAS, a FLVSS, a GPS and a RPM sensor, in their order on the bus
+const SportFrame sportStream[] = {
+  { 0x98, RSSI_ID, 78 },
+  { 0x00, ALT_FIRST_ID, 12345 },
+  { 0x00, VARIO_FIRST_ID, (uint32_t)-25 },
+  { 0x22, CURR_FIRST_ID, 153 },
+  { 0x22, VFAS_FIRST_ID, 1240 },
+  { 0xA1, CELLS_FIRST_ID, 0x33633330 },
+  { 0x83, GPS_ALT_FIRST_ID, 10250 },
+  { 0x83, GPS_SPEED_FIRST_ID, 12000 },
+  { 0xE4, RPM_FIRST_ID, 3600 },
+  { 0x98, RSSI_ID, 77 },
+  { 0x00, ALT_FIRST_ID, 12350 },
+  { 0xA1, CELLS_FIRST_ID, 0x33833392 },
+};
+
+void generateSportPacket(uint8_t * packet, const SportFrame & frame)
+{
+  packet[0] = frame.physicalId;
+  packet[1] = 0x10; //DATA_FRAME
+  *((uint16_t *)(packet+2)) = frame.appId;
+  *((uint32_t *)(packet+4)) = frame.data;
+  setSportPacketCrc(packet);
+}
+
+void replaySportStream(uint8_t (*packets)[FRSKY_SPORT_PACKET_SIZE])
+{
+  for (unsigned int i=0; i<DIM(sportStream); i++) {
+    uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+    memcpy(packet, packets[i], sizeof(packet));
+    processSportPacket(packet);
+  }
+}
+
+void clearTelemetryItems()
+{
+  for (int i=0; i<MAX_SENSORS; i++) {
+    telemetryItems[i].clear();
+  }
+}
+
+TEST(FrSkySPORT, packetsReplay)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  clearTelemetryItems();
+
+  uint8_t packets[DIM(sportStream)][FRSKY_SPORT_PACKET_SIZE];
+  for (unsigned int i=0; i<DIM(sportStream); i++) {
+    generateSportPacket(packets[i], sportStream[i]);
+  }
+
+  // the sensors are discovered once, in the order of the stream
+  replaySportStream(packets);
+  replaySportStream(packets);
+  EXPECT_EQ(lastUsedTelemetryIndex(), 8);
+  EXPECT_EQ(g_model.telemetrySensors[0].id, RSSI_ID);
+  EXPECT_EQ(g_model.telemetrySensors[0].instance, 25);
+  EXPECT_EQ(g_model.telemetrySensors[1].id, ALT_FIRST_ID);
+  EXPECT_EQ(g_model.telemetrySensors[1].instance, 1);
+  EXPECT_EQ(g_model.telemetrySensors[8].id, RPM_FIRST_ID);
+  EXPECT_EQ(telemetryItems[0].value, 77);
+  EXPECT_EQ(telemetryItems[1].value, 12350);
+  EXPECT_EQ(telemetryItems[2].value, -25);
+  EXPECT_EQ(telemetryItems[4].value, 1240);
+
+  // two sensors with the same id and instance both get the values
+  g_model.telemetrySensors[20] = g_model.telemetrySensors[1];
+  g_model.telemetrySensors[20].label[0] = 'B';
+  modelCachesInvalidate();
+  replaySportStream(packets);
+  EXPECT_EQ(telemetryItems[20].value, 12350);
+  delTelemetryIndex(1);
+  replaySportStream(packets);
+  EXPECT_EQ(lastUsedTelemetryIndex(), 20);
+  EXPECT_FALSE(isTelemetryFieldAvailable(1));
+  EXPECT_EQ(telemetryItems[20].value, 12350);
+
+  // a calculated sensor is never routed
+  g_model.telemetrySensors[1].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[1].persistentValue = ALT_FIRST_ID;
+  g_model.telemetrySensors[1].formula = 1;
+  g_model.telemetrySensors[1].label[0] = 'C';
+  modelCachesInvalidate();
+  replaySportStream(packets);
+  EXPECT_EQ(telemetryItems[1].value, 0);
+
+  MODEL_RESET();
+  clearTelemetryItems();
+}
+
+void setCalculatedSensor(int index, uint8_t formula, int8_t source1, int8_t source2=0)
+{
+  TelemetrySensor & sensor = g_model.telemetrySensors[index];
+  sensor.type = TELEM_TYPE_CALCULATED;
+  sensor.formula = formula;
+  sensor.calc.sources[0] = source1;
+  sensor.calc.sources[1] = source2;
+  sensor.unit = g_model.telemetrySensors[1].unit;
+  sensor.prec = g_model.telemetrySensors[1].prec;
+  sensor.label[0] = 'A' + index;
+}
+
+void receiveAltitude(uint32_t altitude)
+{
+  uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+  SportFrame frame = { 0x00, ALT_FIRST_ID, altitude };
+  generateSportPacket(packet, frame);
+  processSportPacket(packet);
+}
+
+TEST(FrSkySPORT, calculatedSensorsChain)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  clearTelemetryItems();
+
+  uint8_t packets[DIM(sportStream)][FRSKY_SPORT_PACKET_SIZE];
+  for (unsigned int i=0; i<DIM(sportStream); i++) {
+    generateSportPacket(packets[i], sportStream[i]);
+  }
+  replaySportStream(packets);
+  EXPECT_EQ(g_model.telemetrySensors[1].id, ALT_FIRST_ID);
+
+  // a chain against the sensors order: 10 reads 11 which reads 12 which reads the altitude
+  setCalculatedSensor(10, TELEM_FORMULA_ADD, 12, 2);
+  setCalculatedSensor(11, TELEM_FORMULA_MAX, 13);
+  setCalculatedSensor(12, TELEM_FORMULA_MIN, 2);
+  // and two sensors which read each other
+  setCalculatedSensor(13, TELEM_FORMULA_ADD, 15, 2);
+  setCalculatedSensor(14, TELEM_FORMULA_ADD, 14, 2);
+  modelCachesInvalidate();
+
+  receiveAltitude(1000);
+  telemetryEvalCalculated();
+  EXPECT_EQ(telemetryItems[12].value, 1000);
+  EXPECT_EQ(telemetryItems[11].value, 1000);
+  EXPECT_EQ(telemetryItems[10].value, 2000);
+
+  // nothing is evaluated again without a change of the sources
+  telemetryItems[10].value = 0;
+  telemetryEvalCalculated();
+  EXPECT_EQ(telemetryItems[10].value, 0);
+
+  receiveAltitude(1200);
+  telemetryEvalCalculated();
+  EXPECT_EQ(telemetryItems[12].value, 1200);
+  EXPECT_EQ(telemetryItems[10].value, 2400);
+
+  // an old altitude makes the whole chain old at once
+  telemetryItems[1].lastReceived = TELEMETRY_VALUE_OLD;
+  telemetryItemChanged(1);
+  telemetryEvalCalculated();
+  EXPECT_TRUE(telemetryItems[12].isOld());
+  EXPECT_TRUE(telemetryItems[11].isOld());
+  EXPECT_TRUE(telemetryItems[10].isOld());
+
+  MODEL_RESET();
+  clearTelemetryItems();
+}
+
+#if defined(PCBTARANIS)
+extern uint8_t telemetryProtocol;
+
+// the bytes of a frame on the bus, as the UART interrupt receives them
+void pushSportBytes(const uint8_t * packet, uint8_t size=FRSKY_SPORT_PACKET_SIZE)
+{
+  telemetryPushByte(START_STOP);
+  for (uint8_t i=0; i<size; i++) {
+    if (packet[i] == START_STOP || packet[i] == BYTESTUFF) {
+      telemetryPushByte(BYTESTUFF);
+      telemetryPushByte(packet[i] ^ STUFF_MASK);
+    }
+    else {
+      telemetryPushByte(packet[i]);
+    }
+  }
+}
+
+TEST(FrSkySPORT, framesPipeline)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  clearTelemetryItems();
+  telemetryProtocol = PROTOCOL_FRSKY_SPORT;
+  telemetryProcessFrames();
+  telemetryStats.reset();
+
+  uint8_t packets[DIM(sportStream)][FRSKY_SPORT_PACKET_SIZE];
+  for (unsigned int i=0; i<DIM(sportStream); i++) {
+    generateSportPacket(packets[i], sportStream[i]);
+    pushSportBytes(packets[i]);
+  }
+  telemetryProcessFrames();
+  EXPECT_EQ(telemetryStats.frames, DIM(sportStream));
+  EXPECT_EQ(lastUsedTelemetryIndex(), 8);
+  EXPECT_EQ(telemetryItems[1].value, 12350);
+
+  // an altitude which needs byte stuffing, after a truncated frame, then a bad CRC
+  uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+  SportFrame frame = { 0x00, ALT_FIRST_ID, 0x7D7E };
+  generateSportPacket(packet, frame);
+  pushSportBytes(packet, 4);
+  pushSportBytes(packet);
+  packet[FRSKY_SPORT_PACKET_SIZE-1] ^= 0x01;
+  pushSportBytes(packet);
+  telemetryProcessFrames();
+  EXPECT_EQ(telemetryItems[1].value, 0x7D7E);
+  EXPECT_EQ(telemetryStats.badFrames, 1u);
+  EXPECT_EQ(telemetryStats.crcErrors, 1u);
+  EXPECT_EQ(telemetryStats.frames, DIM(sportStream)+2);
+
+  // the frames ring keeps 15 frames until the next burst, the others are counted as dropped
+  for (int i=0; i<20; i++) {
+    pushSportBytes(packets[1]);
+  }
+  telemetryProcessFrames();
+  EXPECT_EQ(telemetryStats.droppedFrames, 5u);
+  EXPECT_EQ(telemetryStats.frames, DIM(sportStream)+2+15);
+  EXPECT_EQ(telemetryItems[1].value, 12345);
+  EXPECT_EQ(telemetryStats.uartErrors, 0u);
+
+  MODEL_RESET();
+  clearTelemetryItems();
+  telemetryStats.reset();
+}
+#endif
+
+// writes the stream as SPORT_FILE_LOG does, one line every 100ms for 10s from 23:59:55, the altitude is the line number
+void writeSportLog(const char * filename)
+{
+  FILE * f = fopen(filename, "w");
+  for (int line=0; line<100; line++) {
+    int time = (23*3600 + 59*60 + 55)*10 + line;   // in 100ms
+    fprintf(f, "\r\n2015-03-14,%02d:%02d:%02d.%d00:", (time/36000) % 24, (time/600) % 60, (time/10) % 60, time % 10);
+    for (unsigned int i=0; i<DIM(sportStream); i++) {
+      SportFrame frame = sportStream[i];
+      if (frame.appId == ALT_FIRST_ID) {
+        frame.data = line;
+      }
+      uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+      generateSportPacket(packet, frame);
+      fprintf(f, " %02X", START_STOP);
+      for (int j=0; j<FRSKY_SPORT_PACKET_SIZE; j++) {
+        if (packet[j] == START_STOP || packet[j] == BYTESTUFF)
+          fprintf(f, " %02X %02X", BYTESTUFF, packet[j] ^ STUFF_MASK);
+        else
+          fprintf(f, " %02X", packet[j]);
+      }
+    }
+  }
+  fclose(f);
+}
+
+int replaySportLog(uint16_t speed, int steps=-1)
+{
+  int count = 0;
+  telemetryReplayStart(speed);
+  while (telemetryReplayRunning() && count != steps) {
+    telemetryReplayStep();
+    count++;
+  }
+  return count;
+}
+
+TEST(FrSkySPORT, telemetryReplay)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  clearTelemetryItems();
+
+  char filename[] = "/tmp/opentx-sport-XXXXXX";
+  close(mkstemp(filename));
+  writeSportLog(filename);
+  EXPECT_FALSE(telemetryReplayLoad("/tmp/opentx-sport-missing.log"));
+  ASSERT_TRUE(telemetryReplayLoad(filename));
+  EXPECT_EQ(telemetryReplayDuration(), 991u);
+
+  // the lines are sent at their time, across midnight
+  EXPECT_EQ(replaySportLog(1, 500), 500);
+  EXPECT_EQ(lastUsedTelemetryIndex(), 8);
+  EXPECT_EQ(telemetryItems[1].value, 49);
+  EXPECT_EQ(replaySportLog(1), 991);
+  EXPECT_EQ(telemetryItems[1].value, 99);
+  EXPECT_EQ(telemetryItems[0].value, 77);
+
+  // the same sensors and values at 10 times the speed
+  MODEL_RESET();
+  clearTelemetryItems();
+  EXPECT_EQ(replaySportLog(10), 100);
+  EXPECT_EQ(lastUsedTelemetryIndex(), 8);
+  EXPECT_EQ(g_model.telemetrySensors[8].id, RPM_FIRST_ID);
+  EXPECT_EQ(telemetryItems[1].value, 99);
+#if defined(PCBTARANIS)
+  EXPECT_EQ(telemetryStats.crcErrors, 0u);
+  EXPECT_EQ(telemetryStats.badFrames, 0u);
+#endif
+
+  remove(filename);
+  MODEL_RESET();
+  clearTelemetryItems();
+}
+
 #endif  //#if defined(FRSKY_SPORT)
 
 
@@ -0,0 +1,329 @@
+/*
+ * Authors (alphabetical order)
+ * - Andre Bernet <bernet.andre@gmail.com>
+ * - Andreas Weitl
+ * - Bertrand Songis <bsongis@gmail.com>
+ * - Bryan J. Rentoul (Gruvin) <gruvin@gmail.com>
+ * - Cameron Weeks <th9xer@gmail.com>
+ * - Erez Raviv
+ * - Gabriel Birkus
+ * - Jean-Pierre Parisy
+ * - Karl Szmutny
+ * - Michael Blandford
+ * - Michal Hlavinka
+ * - Pat Mackenzie
+ * - Philip Moss
+ * - Rob Thomson
+ * - Romolo Manfredini <romolo.manfredini@gmail.com>
+ * - Thomas Husterer
+ *
+ * opentx is based on code named
+ * gruvin9x by Bryan J. Rentoul: http://code.google.com/p/gruvin9x/,
+ * er9x by Erez Raviv: http://code.google.com/p/er9x/,
+ * and the original (and ongoing) project by
+ * Thomas Husterer, th9x: http://code.google.com/p/th9x/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+#include <string>
+#include <vector>
+#include "gtests.h"
+
+#if defined(CPUARM) && defined(SDCARD)
+#if defined(PCBTARANIS)
+  #define LOGS_COLUMNS          "Rud,Ele,Thr,Ail,S1,S2,S3,LS,RS,SA,SB,SC,SD,SE,SF,SG,SH"
+  #define LOGS_SWITCHES_COUNT   8
+  #define LOGS_SWITCHES_STATES  "%d,-1,-1,-1,1,-1,-1,-1"   // SA moved by the test
+  #define LOGS_SWITCH_SIGN      1
+#else
+  #define LOGS_COLUMNS          "Rud,Ele,Thr,Ail,P1,P2,P3,THR,RUD,ELE,3POS,AIL,GEA,TRN"
+  #define LOGS_SWITCHES_COUNT   7
+  #define LOGS_SWITCHES_STATES  "%d,1,1,0,1,1,1"           // THR moved by the test
+  #define LOGS_SWITCH_SIGN      -1
+#endif
+
+#if defined(RTCLOCK)
+extern gtime_t filltm(gtime_t * t, struct gtm * tp);
+#endif
+
+// The 10ms interrupt, for what the logs read of it
+void logsTick()
+{
+  g_tmr10ms++;
+#if defined(RTCLOCK)
+  if (++g_ms100 == 100) {
+    g_rtcTime++;
+    g_ms100 = 0;
+  }
+#endif
+}
+
+void logsAppendTime(std::string & line, gtime_t time, int ms10, tmr10ms_t tmr10ms)
+{
+  char buffer[7*11+8+1];  // 7 int of 11 chars at most
+#if defined(RTCLOCK)
+  struct gtm utm;
+  filltm(&time, &utm);
+  snprintf(buffer, sizeof(buffer), "%4d-%02d-%02d,%02d:%02d:%02d.%02d0,", utm.tm_year+1900, utm.tm_mon+1, utm.tm_mday, utm.tm_hour, utm.tm_min, utm.tm_sec, ms10);
+#else
+  snprintf(buffer, sizeof(buffer), "%d,", tmr10ms);
+#endif
+  line += buffer;
+}
+
+void logsAppendValue(std::string & line, int32_t value, uint8_t prec)
+{
+  char buffer[16];
+  if (prec == 2)
+    snprintf(buffer, sizeof(buffer), "%s%d.%02d", value < 0 ? "-" : "", abs(value) / 100, abs(value) % 100);
+  else if (prec == 1)
+    snprintf(buffer, sizeof(buffer), "%s%d.%d", value < 0 ? "-" : "", abs(value) / 10, abs(value) % 10);
+  else
+    snprintf(buffer, sizeof(buffer), "%d", value);
+  line += buffer;
+}
+
+bool readLogsFile(const char * directory, std::vector<uint8_t> & data)
+{
+  std::string path = std::string(directory) + LOGS_PATH;
+  DIR dir;
+  FILINFO info;
+  char lfn[SD_SCREEN_FILE_LENGTH+1];
+  info.lfname = lfn;
+  info.lfsize = sizeof(lfn);
+  if (f_opendir(&dir, LOGS_PATH) != FR_OK)
+    return false;
+  while (f_readdir(&dir, &info) == FR_OK && info.fname[0]) {
+    if (info.fname[0] != '.') {
+      path += std::string("/") + info.lfname;
+      break;
+    }
+  }
+  f_closedir(&dir);
+  FILE * f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  uint8_t buffer[512];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    data.insert(data.end(), buffer, buffer+count);
+  fclose(f);
+  unlink(path.c_str());
+  rmdir((std::string(directory) + LOGS_PATH).c_str());
+  return true;
+}
+
+#if defined(BINARY_LOGS)
+uint32_t logsRead(const std::vector<uint8_t> & data, size_t offset, int size)
+{
+  uint32_t result = 0;
+  for (int i=size-1; i>=0; i--)
+    result = (result << 8) + data[offset+i];
+  return result;
+}
+
+// The binary logs converted to the CSV layout, as util/logs2csv.py does
+void logsDecode(const std::vector<uint8_t> & data, std::vector<std::string> & lines)
+{
+  size_t offset = 0;
+  uint8_t count = 0;
+  uint8_t types[64], precs[64];
+  int32_t values[64];
+  uint32_t start = 0, tmr10ms = 0;
+  gtime_t date = 0;
+  int ms10 = 0;
+  while (offset < data.size()) {
+    if (!memcmp(&data[offset], "OTXL", 4)) {
+      // magic, version, fieldsCount, period, tmr10ms, rtc, year, month, day, hour, min, sec, ms10
+      count = data[offset+5];
+      start = logsRead(data, offset+8, 4);
+#if defined(RTCLOCK)
+      struct gtm utm;
+      memclear(&utm, sizeof(utm));
+      utm.tm_year = logsRead(data, offset+13, 2) - 1900;
+      utm.tm_mon = data[offset+15] - 1;
+      utm.tm_mday = data[offset+16];
+      utm.tm_hour = data[offset+17];
+      utm.tm_min = data[offset+18];
+      utm.tm_sec = data[offset+19];
+      ms10 = data[offset+20];
+      date = gmktime(&utm);
+#endif
+      offset += 21;
+      std::string columns;
+#if defined(RTCLOCK)
+      columns = "Date,Time";
+#else
+      columns = "Time";
+#endif
+      for (int i=0; i<count; i++) {
+        types[i] = data[offset];
+        precs[i] = data[offset+1];
+        columns += std::string(",") + (const char *)&data[offset+2];
+        offset += 3 + strlen((const char *)&data[offset+2]);
+      }
+      if (lines.empty() || lines[0] != columns)
+        lines.push_back(columns);
+      continue;
+    }
+    if (data[offset] == 'K') {
+      tmr10ms = logsRead(data, offset+1, 4);
+      for (int i=0; i<count; i++)
+        values[i] = logsRead(data, offset+5+4*i, 4);
+      offset += 5 + 4*count;
+    }
+    else {
+      EXPECT_EQ(data[offset], 'D');
+      tmr10ms += data[offset+1];
+      for (int i=0; i<count; i++)
+        values[i] += (int16_t)logsRead(data, offset+2+2*i, 2);
+      offset += 2 + 2*count;
+    }
+    std::string line;
+    uint32_t elapsed = ms10 + (tmr10ms - start);
+    logsAppendTime(line, date + elapsed / 100, elapsed % 100, tmr10ms);
+    for (int i=0; i<count; i++) {
+      if (i > 0)
+        line += ",";
+      if (types[i] == 1) {
+        for (int s=0; s<LOGS_SWITCHES_COUNT; s++) {
+          char buffer[8];
+          snprintf(buffer, sizeof(buffer), s > 0 ? ",%d" : "%d", ((values[i] >> (2*s)) & 3) - 1);
+          line += buffer;
+        }
+      }
+      else {
+        logsAppendValue(line, values[i], precs[i]);
+      }
+    }
+    lines.push_back(line);
+  }
+}
+#else
+void logsDecode(const std::vector<uint8_t> & data, std::vector<std::string> & lines)
+{
+  std::string text(data.begin(), data.end());
+  size_t start = 0, end;
+  while ((end = text.find('\n', start)) != std::string::npos) {
+    lines.push_back(text.substr(start, end-start));
+    start = end + 1;
+  }
+}
+#endif
+
+// The logs of both formats give the same CSV lines for the same inputs
+TEST(Logs, CsvLines)
+{
+  char sdDirectory[sizeof(simuSdDirectory)];
+  strcpy(sdDirectory, simuSdDirectory);
+  char tmpDirectory[] = "/tmp/opentx-gtests-XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpDirectory) != NULL);
+  strcpy(simuSdDirectory, tmpDirectory);
+  // f_mkdir() does nothing in the simulator
+  ASSERT_EQ(mkdir((std::string(tmpDirectory) + LOGS_PATH).c_str(), 0777), 0);
+
+  MODEL_RESET();
+  for (int i=0; i<MAX_SENSORS; i++) {
+    telemetryItems[i].clear();
+  }
+  const uint8_t precs[] = { 0, 1, 2 };
+  for (int i=0; i<3; i++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[2*i];
+    str2zchar(sensor.label, i == 0 ? "Alt" : (i == 1 ? "VFAS" : "Curr"), TELEM_LABEL_LEN);
+    sensor.unit = (i == 1 ? UNIT_VOLTS : UNIT_RAW);
+    sensor.prec = precs[i];
+    sensor.logs = 1;
+  }
+  // a sensor which is not logged
+  str2zchar(g_model.telemetrySensors[1].label, "RSSI", TELEM_LABEL_LEN);
+
+  g_rtcTime = 1420113600;  // 2015-01-01 12:00:00
+  g_ms100 = 95;
+  g_tmr10ms = 1000;
+  logDelay = 1;
+  modelFunctionsContext.reset();
+  modelFunctionsContext.activeFunctions |= (1 << FUNCTION_LOGS);
+
+  std::vector<std::string> expected;
+  std::string columns;
+#if defined(RTCLOCK)
+  columns = "Date,Time";
+#else
+  columns = "Time";
+#endif
+#if defined(FRSKY)
+  columns += ",Alt,VFAS(v),Curr";
+#endif
+  columns += "," LOGS_COLUMNS;
+  expected.push_back(columns);
+
+  tmr10ms_t lastSample = 0;
+  for (int i=0; i<1500; i++) {
+    // slow and fast changes, and a jump which doesn't fit in a difference
+    telemetryItems[0].value = 100 + i / 7;
+    telemetryItems[2].value = (i % 40) * 29 - 500;
+    telemetryItems[4].value = (i == 600 ? 100000 : -i * 3);
+    telemetryItems[1].value = i;
+    for (int s=0; s<NUM_STICKS+NUM_POTS; s++)
+      calibratedStick[s] = ((i * (s+1) * 13) % 2048) - 1024;
+    int8_t state = ((i / 100) % 2 ? 1 : -1);
+    simuSetSwitch(0, state);
+
+    tmr10ms_t tmr10ms = get_tmr10ms();
+    bool sample = (lastSample == 0 || (tmr10ms_t)(tmr10ms - lastSample) >= (tmr10ms_t)logDelay*10);
+    if (sample) {
+      lastSample = tmr10ms;
+    }
+
+#if defined(BINARY_LOGS)
+    writeLogs();
+    sampleLogs();
+#else
+    writeLogs();
+#endif
+
+    if (sample) {
+      std::string line;
+      logsAppendTime(line, g_rtcTime, g_ms100, tmr10ms);
+#if defined(FRSKY)
+      for (int s=0; s<3; s++) {
+        logsAppendValue(line, telemetryItems[2*s].value, precs[s]);
+        line += ",";
+      }
+#endif
+      for (int s=0; s<NUM_STICKS+NUM_POTS; s++) {
+        logsAppendValue(line, calibratedStick[s], 0);
+        line += ",";
+      }
+      char switches[32];
+      snprintf(switches, sizeof(switches), LOGS_SWITCHES_STATES, LOGS_SWITCH_SIGN * state);
+      expected.push_back(line + switches);
+    }
+
+    logsTick();
+  }
+
+  modelFunctionsContext.reset();
+  writeLogs();
+
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(readLogsFile(tmpDirectory, data));
+  std::vector<std::string> lines;
+  logsDecode(data, lines);
+  EXPECT_EQ(lines.size(), expected.size());
+  for (unsigned int i=0; i<lines.size() && i<expected.size(); i++) {
+    EXPECT_EQ(lines[i], expected[i]) << "line " << i;
+  }
+
+  rmdir(tmpDirectory);
+  strcpy(simuSdDirectory, sdDirectory);
+}
+#endif
@@ -35,6 +35,9 @@
  */
 
 #include <math.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
 #include <gtest/gtest.h>
 #include "gtests.h"
 
@@ -46,6 +49,7 @@
 #include <lua.h>
 #include <lauxlib.h>
 #include <lualib.h>
+#include "pool_allocator.h"
 
 extern const char * zchar2string(const char * zstring, int size);
 #define EXPECT_ZSTREQ(c_string, z_string)   EXPECT_STREQ(c_string, zchar2string(z_string, sizeof(z_string)))
@@ -135,7 +139,7 @@ TEST(Lua, testModelInputs)
 
   // add one line on Input4
   luaExecStr("model.insertInput(3, 0, {name='test1', source=MIXSRC_Thr, weight=56, offset=3, switch=2})");
-  EXPECT_EQ(3, g_model.expoData[0].chn);
+  EXPECT_EQ(3u, g_model.expoData[0].chn);
   EXPECT_ZSTREQ("test1", g_model.expoData[0].name);
   EXPECT_EQ(MIXSRC_Thr, g_model.expoData[0].srcRaw);
   EXPECT_EQ(56, g_model.expoData[0].weight);
@@ -144,14 +148,14 @@ TEST(Lua, testModelInputs)
 
   // add another one before existing line on Input4
   luaExecStr("model.insertInput(3, 0, {name='test2', source=MIXSRC_Rud, weight=-56})");
-  EXPECT_EQ(3, g_model.expoData[0].chn);
+  EXPECT_EQ(3u, g_model.expoData[0].chn);
   EXPECT_ZSTREQ("test2", g_model.expoData[0].name);
   EXPECT_EQ(MIXSRC_Rud, g_model.expoData[0].srcRaw);
   EXPECT_EQ(-56, g_model.expoData[0].weight);
   EXPECT_EQ(0, g_model.expoData[0].offset);
   EXPECT_EQ(0, g_model.expoData[0].swtch);
 
-  EXPECT_EQ(3, g_model.expoData[1].chn);
+  EXPECT_EQ(3u, g_model.expoData[1].chn);
   EXPECT_ZSTREQ("test1", g_model.expoData[1].name);
   EXPECT_EQ(MIXSRC_Thr, g_model.expoData[1].srcRaw);
   EXPECT_EQ(56, g_model.expoData[1].weight);
@@ -160,21 +164,21 @@ TEST(Lua, testModelInputs)
 
   // add another line after existing lines on Input4
   luaExecStr("model.insertInput(3, model.getInputsCount(3), {name='test3', source=MIXSRC_Ail, weight=100})");
-  EXPECT_EQ(3, g_model.expoData[0].chn);
+  EXPECT_EQ(3u, g_model.expoData[0].chn);
   EXPECT_ZSTREQ("test2", g_model.expoData[0].name);
   EXPECT_EQ(MIXSRC_Rud, g_model.expoData[0].srcRaw);
   EXPECT_EQ(-56, g_model.expoData[0].weight);
   EXPECT_EQ(0, g_model.expoData[0].offset);
   EXPECT_EQ(0, g_model.expoData[0].swtch);
 
-  EXPECT_EQ(3, g_model.expoData[1].chn);
+  EXPECT_EQ(3u, g_model.expoData[1].chn);
   EXPECT_ZSTREQ("test1", g_model.expoData[1].name);
   EXPECT_EQ(MIXSRC_Thr, g_model.expoData[1].srcRaw);
   EXPECT_EQ(56, g_model.expoData[1].weight);
   EXPECT_EQ(3, g_model.expoData[1].offset);
   EXPECT_EQ(2, g_model.expoData[1].swtch);
 
-  EXPECT_EQ(3, g_model.expoData[2].chn);
+  EXPECT_EQ(3u, g_model.expoData[2].chn);
   EXPECT_ZSTREQ("test3", g_model.expoData[2].name);
   EXPECT_EQ(MIXSRC_Ail, g_model.expoData[2].srcRaw);
   EXPECT_EQ(100, g_model.expoData[2].weight);
@@ -187,4 +191,287 @@ TEST(Lua, testModelInputs)
 
 }
 
+TEST(Lua, testIncrementalGc)
+{
+  luaExecStr("garbage = {} for i=1,100 do garbage[i] = {i} end");
+  luaExecStr("garbage = nil");
+  int used = luaGetMemUsed();
+
+  // the garbage is collected in small steps, in several calls
+  luaHeapAfterGc = 0;
+  for (int i=0; i<100 && luaHeapAfterGc==0; i++) {
+    luaDoGc();
+  }
+  EXPECT_GT(luaHeapAfterGc, 0);
+  EXPECT_LT(luaHeapAfterGc, used);
+
+  // a heap near its limit is fully collected at once
+  luaExecStr("garbage = {} for i=1,5000 do garbage[i] = {i} end");
+  luaExecStr("garbage = nil");
+  used = luaGetMemUsed();
+  EXPECT_GT(used, 64*1024);
+  luaHeapAfterGc = 0;
+  luaDoGc();
+  EXPECT_EQ(luaHeapAfterGc, luaGetMemUsed());
+  EXPECT_LT(luaHeapAfterGc, used/4);
+}
+
+TEST(Lua, testFieldNames)
+{
+  MODEL_RESET();
+
+  // static fields, the first and the last ones of the sorted table
+  luaExecStr("if getFieldInfo('ail').id ~= MIXSRC_Ail then error('ail') end");
+  luaExecStr("if getFieldInfo('thr').id ~= MIXSRC_Thr then error('thr') end");
+  luaExecStr("if getFieldInfo('tx-voltage') == nil then error('tx-voltage') end");
+  luaExecStr("if getFieldInfo('ls').desc ~= 'Left slider' then error('ls') end");
+  luaExecStr("if getFieldInfo('ls1').desc ~= 'Logical switch L1' then error('ls1') end");
+  luaExecStr("if getFieldInfo('zzz') ~= nil or getFieldInfo('a') ~= nil then error('unknown') end");
+
+  // sensors, with their min and max values
+  str2zchar(g_model.telemetrySensors[0].label, "Alt", TELEM_LABEL_LEN);
+  str2zchar(g_model.telemetrySensors[2].label, "Alt-", TELEM_LABEL_LEN);
+  modelCachesInvalidate();
+  luaExecStr("alt = getFieldInfo('Alt').id");
+  luaExecStr("if getFieldInfo('Alt+').id ~= alt+2 then error('Alt+') end");
+  luaExecStr("if getFieldInfo('Alt-').id ~= alt+6 then error('Alt-') end");
+  luaExecStr("if getFieldInfo('Alt--').id ~= alt+7 then error('Alt--') end");
+  luaExecStr("if getFieldInfo('Vfas') ~= nil then error('Vfas') end");
+
+  // the table is reloaded after the sensors changed
+  str2zchar(g_model.telemetrySensors[1].label, "Vfas", TELEM_LABEL_LEN);
+  modelCachesInvalidate();
+  luaExecStr("if getFieldInfo('Vfas').id ~= alt+3 then error('Vfas') end");
+
+  // the ids give the same values as the names
+  ex_chans[0] = 42;
+  luaExecStr("if getValue(getFieldInfo('ch1').id) ~= 42 or getValue('ch1') ~= 42 then error('ch1') end");
+  ex_chans[0] = 0;
+#if defined(GVARS)
+  GVAR_VALUE(0, 0) = 42;
+  luaExecStr("if getValue(getFieldInfo('gvar1').id) ~= 42 or getValue('gvar1') ~= 42 then error('gvar1') end");
+#endif
+
+  MODEL_RESET();
+  modelCachesInvalidate();
+}
+
+TEST(Lua, testGetValues)
+{
+  MODEL_RESET();
+  ex_chans[0] = 42;
+  ex_chans[2] = -7;
+
+  luaExecStr("names = {'thr', 'ch1', getFieldInfo('ch3').id, 'ls1', 'unknown'}");
+  luaExecStr("handle = registerValues(names)");
+  luaExecStr("values = getValues(handle)");
+  luaExecStr("if #values ~= #names then error('count') end");
+  luaExecStr("if values[2] ~= 42 or values[3] ~= -7 or values[5] ~= 0 then error('values') end");
+  luaExecStr("for i=1,#names do if values[i] ~= getValue(names[i]) then error('value '..i) end end");
+
+  // the table given is filled again, each frame
+  ex_chans[0] = 43;
+  luaExecStr("if getValues(handle, values) ~= values or values[2] ~= 43 then error('reused') end");
+
+#if defined(GVARS)
+  GVAR_VALUE(0, 0) = 12;
+  luaExecStr("gvars = getValues(registerValues({'gvar1', getFieldInfo('gvar1').id}))");
+  luaExecStr("if gvars[1] ~= 12 or gvars[2] ~= 12 then error('gvars') end");
+  GVAR_VALUE(0, 0) = 0;
+#endif
+
+  // the handle is checked
+  EXPECT_FALSE(__luaExecStr("getValues(names)"));
+
+  ex_chans[0] = 0;
+  ex_chans[2] = 0;
+}
+
+TEST(Lua, testPoolAllocator)
+{
+  PoolAllocator<16, 4> pool;
+  pool.clear();
+  void * a = pool.malloc(10);
+  void * b = pool.malloc(16);
+  EXPECT_TRUE(pool.is_member(a));
+  EXPECT_TRUE(pool.is_member(b));
+  int outside;
+  EXPECT_FALSE(pool.is_member(&outside));
+  EXPECT_EQ(pool.size(), 2u);
+  EXPECT_EQ(pool.wasted(), 6u);
+
+  // the last freed slot is the next one used
+  pool.free(a, 10);
+  EXPECT_EQ(pool.malloc(8), a);
+  EXPECT_NE(pool.malloc(8), (void *)NULL);
+  EXPECT_NE(pool.malloc(8), (void *)NULL);
+  EXPECT_EQ(pool.malloc(8), (void *)NULL);
+  EXPECT_EQ(pool.size(), 4u);
+  pool.free(b, 16);
+  EXPECT_EQ(pool.size(), 3u);
+  EXPECT_EQ(pool.maxSize(), 4u);
+
+  // the Lua wrapper, the pools are shared with the interpreter
+  PoolAllocatorStats before, after;
+  poolAllocatorGetStats(before);
+  char * p = (char *)pool_l_alloc(NULL, NULL, LUA_TSTRING, 10);
+  EXPECT_EQ(poolAllocatorSize(p), 16u);
+  strcpy(p, "opentx");
+  EXPECT_EQ(pool_l_alloc(NULL, p, 10, 14), p);
+  p = (char *)pool_l_alloc(NULL, p, 14, 100);
+  EXPECT_EQ(poolAllocatorSize(p), 128u);
+  EXPECT_STREQ(p, "opentx");
+  void * big = pool_l_alloc(NULL, NULL, LUA_TTABLE, 1000);
+  EXPECT_EQ(poolAllocatorSize(big), 0u);
+  poolAllocatorGetStats(after);
+  EXPECT_EQ(after.libcAllocations, before.libcAllocations + 1);
+  EXPECT_EQ(after.used[0], before.used[0] + 1000);
+  EXPECT_EQ(after.used[4], before.used[4] + 1);
+  EXPECT_EQ(pool_l_alloc(NULL, p, 100, 0), (void *)NULL);
+  EXPECT_EQ(pool_l_alloc(NULL, big, 1000, 0), (void *)NULL);
+  poolAllocatorGetStats(after);
+  EXPECT_EQ(memcmp(after.used, before.used, sizeof(before.used)), 0);
+  EXPECT_EQ(after.wasted, before.wasted);
+}
+
+#if defined(SDCARD)
+struct LuaAllocStats {
+  lua_Alloc alloc;
+  void * ud;
+  long used;    // since the start of the measure, the blocks allocated before may be freed
+  long peak;
+};
+
+void * luaPeakAlloc(void * ud, void * ptr, size_t osize, size_t nsize)
+{
+  LuaAllocStats & stats = *(LuaAllocStats *)ud;
+  void * result = stats.alloc(stats.ud, ptr, osize, nsize);
+  if (result || nsize == 0) {
+    stats.used += (long)nsize - (ptr ? (long)osize : 0);
+    if (stats.used > stats.peak)
+      stats.peak = stats.used;
+  }
+  return result;
+}
+
+void writeLuaScript(const char * path, int factor, time_t mtime)
+{
+  FILE * f = fopen(path, "w");
+  fprintf(f, "local t = {}\n");
+  for (int i=0; i<50; i++) {
+    fprintf(f, "t[%d] = function(a, b) if a > b then return a * %d + b else return { a, b, 'x%d' } end end\n", i, i, i);
+  }
+  fprintf(f, "local function run(a, b) return t[1](a, b) * %d + b, #t end\n", factor);
+  fprintf(f, "return { run=run }\n");
+  fclose(f);
+  struct utimbuf times = { mtime, mtime };
+  utime(path, &times);
+}
+
+void touchLuaFile(const char * path, time_t mtime)
+{
+  struct utimbuf times = { mtime, mtime };
+  utime(path, &times);
+}
+
+int luaRunScript(const char * filename, LuaAllocStats * stats=NULL)
+{
+  extern lua_State * L;
+  if (stats) {
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    stats->alloc = lua_getallocf(L, &stats->ud);
+    stats->used = stats->peak = 0;
+    lua_setallocf(L, luaPeakAlloc, stats);
+  }
+  int result = luaLoadScriptFile(filename);
+  if (stats)
+    lua_setallocf(L, stats->alloc, stats->ud);
+  if (result != 0) {
+    lua_pop(L, 1);
+    return -1;
+  }
+  EXPECT_EQ(lua_pcall(L, 0, 1, 0), 0);
+  lua_getfield(L, -1, "run");
+  lua_pushinteger(L, 3);
+  lua_pushinteger(L, 2);
+  EXPECT_EQ(lua_pcall(L, 2, 2, 0), 0);
+  EXPECT_EQ(lua_tointeger(L, -1), 49);
+  result = lua_tointeger(L, -2);
+  lua_pop(L, 3);
+  return result;
+}
+
+TEST(Lua, testBytecodeCache)
+{
+  extern lua_State * L;
+  if (!L) luaInit();
+  ASSERT_TRUE(L != NULL);
+
+  char sdDirectory[sizeof(simuSdDirectory)];
+  strcpy(sdDirectory, simuSdDirectory);
+  char tmpDirectory[] = "/tmp/opentx-gtests-XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpDirectory) != NULL);
+  strcpy(simuSdDirectory, tmpDirectory);
+  char source[sizeof(tmpDirectory)+16], bytecode[sizeof(tmpDirectory)+16];
+  sprintf(source, "%s/test.lua", tmpDirectory);
+  sprintf(bytecode, "%s/test.luac", tmpDirectory);
+  const time_t t0 = 1420070400; // 2015-01-01
+
+  // the first load compiles the script and writes its bytecode
+  writeLuaScript(source, 10, t0);
+  EXPECT_EQ(luaRunScript("/test.lua"), (3*1+2)*10+2);
+  // the .luac starts with the 12 bytes of the date, time and size of the source
+  FILE * f = fopen(bytecode, "rb");
+  ASSERT_TRUE(f != NULL);
+  char header[17] = { 0 };
+  EXPECT_EQ(fread(header, 1, 16, f), 16u);
+  fclose(f);
+  EXPECT_EQ(memcmp(header, "OTXC", 4), 0);
+  EXPECT_STREQ(header+12, LUA_SIGNATURE);
+
+  // the bytecode is used while the source has the same date, time and size
+  writeLuaScript(source, 20, t0);
+  EXPECT_EQ(luaRunScript("/test.lua"), (3*1+2)*10+2);
+
+  // a source with another date is compiled again, even older than the bytecode
+  touchLuaFile(source, t0+200);
+  EXPECT_EQ(luaRunScript("/test.lua"), (3*1+2)*20+2);
+  writeLuaScript(source, 30, t0-200);
+  EXPECT_EQ(luaRunScript("/test.lua"), (3*1+2)*30+2);
+
+  // a source with another size is compiled again, even with the same date
+  writeLuaScript(source, 100, t0-200);
+  EXPECT_EQ(luaRunScript("/test.lua"), (3*1+2)*100+2);
+
+  // the bytecode isn't used without its source
+  unlink(source);
+  EXPECT_EQ(luaRunScript("/test.lua"), -1);
+  writeLuaScript(source, 20, t0);
+
+  // a bytecode written by another Lua version is replaced
+  EXPECT_EQ(luaRunScript("/test.lua"), (3*1+2)*20+2);
+  f = fopen(bytecode, "r+b");
+  fseek(f, 12+4, SEEK_SET);
+  fputc(0x51, f);
+  fclose(f);
+  EXPECT_EQ(luaRunScript("/test.lua"), (3*1+2)*20+2);
+  f = fopen(bytecode, "rb");
+  fseek(f, 12+4, SEEK_SET);
+  EXPECT_EQ(fgetc(f), LUA_VERSION_NUM/100*16 + LUA_VERSION_NUM%100);
+  fclose(f);
+
+  // the bytecode needs less memory than the source to be loaded, the durations are given by the bench
+  LuaAllocStats compiled, loaded;
+  unlink(bytecode);
+  EXPECT_EQ(luaRunScript("/test.lua", &compiled), (3*1+2)*20+2);
+  EXPECT_EQ(luaRunScript("/test.lua", &loaded), (3*1+2)*20+2);
+  EXPECT_LT(loaded.peak, compiled.peak);
+
+  unlink(source);
+  unlink(bytecode);
+  rmdir(tmpDirectory);
+  strcpy(simuSdDirectory, sdDirectory);
+}
+#endif
+
 #endif   // #if defined(LUA)
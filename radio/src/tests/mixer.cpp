@@ -35,6 +35,7 @@
  */
 
 #include "gtests.h"
+#include "timers.h"
 
 #define CHECK_NO_MOVEMENT(channel, value, duration) \
     for (int i=1; i<=(duration); i++) { \
@@ -440,6 +441,118 @@ TEST(Curves, LinearIntpol)
   EXPECT_EQ(applyCustomCurve(-192, 0), -192);
 }
 
+#if defined(XCURVES)
+s32 compute_tangent(CurveInfo *crv, int8_t *points, int i);
+int16_t hermite_spline(int16_t x, uint8_t idx);
+
+// the hermite_spline() algorithm before the splines were cached
+int16_t referenceSpline(int16_t x, uint8_t idx)
+{
+  CurveInfo &crv = g_model.curves[idx];
+  int8_t *points = curveAddress(idx);
+  uint8_t count = crv.points+5;
+  bool custom = (crv.type == CURVE_TYPE_CUSTOM);
+
+  if (x < -RESX)
+    x = -RESX;
+  else if (x > RESX)
+    x = RESX;
+
+  for (int i=0; i<count-1; i++) {
+    s32 p0x, p3x;
+    if (custom) {
+      p0x = (i>0 ? calc100toRESX(points[count+i-1]) : -RESX);
+      p3x = (i<count-2 ? calc100toRESX(points[count+i]) : RESX);
+    }
+    else {
+      p0x = -RESX + (i*2*RESX)/(count-1);
+      p3x = -RESX + ((i+1)*2*RESX)/(count-1);
+    }
+    if (x >= p0x && x <= p3x) {
+      s32 p0y = calc100toRESX(points[i]);
+      s32 p3y = calc100toRESX(points[i+1]);
+      s32 m0 = compute_tangent(&crv, points, i);
+      s32 m3 = compute_tangent(&crv, points, i+1);
+      s32 h = p3x - p0x;
+      s32 t = (h > 0 ? (1024 * (x - p0x)) / h : 0);
+      s32 t2 = t * t / 1024;
+      s32 t3 = t2 * t / 1024;
+      s32 h00 = 2*t3 - 3*t2 + 1024;
+      s32 h10 = t3 - 2*t2 + t;
+      s32 h01 = -2*t3 + 3*t2;
+      s32 h11 = t3 - t2;
+      s32 y = p0y * h00 + h * (m0 * h10 / 1024) + p3y * h01 + h * (m3 * h11 / 1024);
+      return y / 1024;
+    }
+  }
+  return 0;
+}
+
+TEST(Curves, SmoothSplinesCache)
+{
+  MODEL_RESET();
+  srand(0);
+  for (int test=0; test<50; test++) {
+    memclear(g_model.points, sizeof(g_model.points));
+    for (int c=0; c<4; c++) {
+      g_model.curves[c].type = (c & 1) ? CURVE_TYPE_CUSTOM : CURVE_TYPE_STANDARD;
+      g_model.curves[c].smooth = 1;
+      g_model.curves[c].points = (rand() % 16) - 3;
+    }
+    loadCurves();
+    for (int c=0; c<4; c++) {
+      int8_t * points = curveAddress(c);
+      uint8_t count = g_model.curves[c].points+5;
+      for (int i=0; i<count; i++)
+        points[i] = (rand() % 201) - 100;
+      if (g_model.curves[c].type == CURVE_TYPE_CUSTOM) {
+        int8_t x = -100;
+        for (int i=0; i<count-2; i++) {
+          x += rand() % ((100-x) / (count-2-i) + 1);
+          points[count+i] = x;
+        }
+      }
+    }
+    modelCachesInvalidate();
+    for (int c=0; c<4; c++) {
+      for (int x=-RESX-10; x<=RESX+10; x++) {
+        EXPECT_EQ(referenceSpline(x, c), hermite_spline(x, c));
+      }
+    }
+    // a point is edited
+    curveAddress(0)[1] = -curveAddress(0)[1];
+    modelCachesInvalidate();
+    for (int x=-RESX; x<=RESX; x++) {
+      EXPECT_EQ(referenceSpline(x, 0), hermite_spline(x, 0));
+    }
+  }
+}
+#endif
+
+#if defined(CPUARM)
+TEST(Curves, ExpoTables)
+{
+  for (int k=-100; k<=100; k++) {
+    if (k == 0) continue;
+    // the table is built when k misses a second time
+    EXPECT_EQ(NULL, expoTableGet(k));
+    ExpoTable * table = expoTableGet(k);
+    ASSERT_NE((ExpoTable *)NULL, table);
+    EXPECT_EQ(table, expoTableGet(k));
+    for (int i=0; i<EXPO_TABLE_POINTS; i++) {
+      EXPECT_EQ(expoCubic(i*EXPO_TABLE_STEP, k), table->y[i]);
+    }
+    for (int x=-RESX; x<=RESX; x++) {
+      EXPECT_NEAR(expoCubic(x, k), expo(x, k), 1) << "k=" << k << " x=" << x;
+    }
+    // outside of the table
+    EXPECT_EQ(expoCubic(RESX+100, k), expo(RESX+100, k));
+    EXPECT_EQ(expoCubic(-RESX-100, k), expo(-RESX-100, k));
+  }
+  EXPECT_EQ(300, expo(300, 0));
+}
+#endif
+
 
 #if !defined(CPUARM)
 TEST(FlightModes, nullFadeOut_posFadeIn)
@@ -639,6 +752,469 @@ TEST(Mixer, RecursiveAddChannelAfterInactivePhase)
   EXPECT_EQ(chans[1], CHANNEL_MAX);
 }
 
+#if defined(CPUARM)
+TEST(Mixer, PlanCascadedChannels)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].srcRaw = MIXSRC_CH2;
+  g_model.mixData[0].weight = 100;
+  g_model.mixData[1].destCh = 1;
+  g_model.mixData[1].srcRaw = MIXSRC_CH3;
+  g_model.mixData[1].weight = 100;
+  g_model.mixData[2].destCh = 2;
+  g_model.mixData[2].srcRaw = MIXSRC_MAX;
+  g_model.mixData[2].weight = 100;
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(mixerPlan.state, MIXER_PLAN_ORDERED);
+  EXPECT_EQ(mixerPlan.count, 3);
+  EXPECT_EQ(mixerPlan.lines[0], 2);
+  EXPECT_EQ(mixerPlan.lines[1], 1);
+  EXPECT_EQ(mixerPlan.lines[2], 0);
+  EXPECT_EQ(chans[0], CHANNEL_MAX);
+  EXPECT_EQ(chans[1], CHANNEL_MAX);
+  EXPECT_EQ(chans[2], CHANNEL_MAX);
+}
+
+TEST(Mixer, PlanRecursiveChannels)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].srcRaw = MIXSRC_CH2;
+  g_model.mixData[0].weight = 100;
+  g_model.mixData[1].destCh = 1;
+  g_model.mixData[1].srcRaw = MIXSRC_CH1;
+  g_model.mixData[1].weight = 100;
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  EXPECT_EQ(mixerPlan.state, MIXER_PLAN_MULTIPASS);
+}
+
+TEST(Mixer, PlanSlowOnNextChannel)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  g_model.mixData[0].destCh = 0;
+  g_model.mixData[0].srcRaw = MIXSRC_CH2;
+  g_model.mixData[0].weight = 100;
+  g_model.mixData[0].speedUp = SLOW_STEP*5;
+  g_model.mixData[1].destCh = 1;
+  g_model.mixData[1].srcRaw = MIXSRC_MAX;
+  g_model.mixData[1].weight = 100;
+  evalFlightModeMixes(e_perout_mode_normal, 0);
+  // the multi-pass loop first evaluates the slow with the previous CH2 value
+  EXPECT_EQ(mixerPlan.state, MIXER_PLAN_MULTIPASS);
+}
+
+TEST(Mixer, PlanSameOutputsAsMultiPass)
+{
+  int orderedModels = 0;
+  srand(0);
+  for (int model=0; model<200; model++) {
+    MODEL_RESET();
+    MIXER_RESET();
+    for (int i=0; i<NUM_STICKS; i++) {
+      anaInValues[i] = rand() % 2048 - 1024;
+    }
+    int count = 0;
+    for (int ch=0; ch<8; ch++) {
+      int lines = rand() % 3;
+      for (int j=0; j<lines; j++) {
+        MixData * md = &g_model.mixData[count++];
+        md->destCh = ch;
+        md->mltpx = rand() % 3;
+        md->srcRaw = (rand() % 2) ? MIXSRC_CH1 + rand() % 8 : MIXSRC_Rud + rand() % NUM_STICKS;
+        md->weight = rand() % 201 - 100;
+      }
+    }
+    evalFlightModeMixes(e_perout_mode_normal, 0);
+    if (mixerPlan.state != MIXER_PLAN_ORDERED)
+      continue;
+    orderedModels++;
+    int32_t orderedChans[NUM_CHNOUT];
+    memcpy(orderedChans, chans, sizeof(chans));
+    for (uint8_t i=0; i<mixerPlan.count; i++) {
+      mixerPlan.lines[i] = i;
+    }
+    mixerPlan.state = MIXER_PLAN_MULTIPASS;
+    evalFlightModeMixes(e_perout_mode_normal, 0);
+    for (int ch=0; ch<NUM_CHNOUT; ch++) {
+      EXPECT_EQ(chans[ch], orderedChans[ch]);
+    }
+  }
+  EXPECT_GT(orderedModels, 0);
+}
+
+void fadeRandomModel()
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  memclear(anas, sizeof(anas)); // the inputs disabled in a flight mode keep their last value
+  lastFlightMode = 255;
+  g_model.flightModeData[1].swtch = TR(SWSRC_THR, SWSRC_SA0);
+  for (int p=0; p<2; p++) {
+    g_model.flightModeData[p].fadeIn = rand() % 4;
+    g_model.flightModeData[p].fadeOut = rand() % 4;
+    for (int i=0; i<NUM_STICKS; i++) {
+#if defined(PCBTARANIS)
+      g_model.flightModeData[p].trim[i].mode = 2*p;
+#endif
+      setTrimValue(p, i, rand() % 100 - 50);
+    }
+#if defined(GVARS)
+    for (int g=0; g<3; g++) {
+      SET_GVAR(g, rand() % 200 - 100, p);
+    }
+#endif
+  }
+  for (int i=0; i<NUM_STICKS; i++) {
+    ExpoData * ed = expoAddress(i);
+    ed->mode = 3;
+    ed->chn = i;
+    ed->weight = 100;
+#if defined(VIRTUALINPUTS)
+    ed->srcRaw = MIXSRC_Rud + i;
+#endif
+    if (rand() % 4 == 0)
+      ed->flightModes = 1 << (rand() % 2);
+#if defined(GVARS)
+    if (rand() % 4 == 0)
+      ed->weight = GV1_SMALL + rand() % 3;
+#endif
+  }
+  int count = 0;
+  for (int ch=0; ch<8; ch++) {
+    int lines = rand() % 3;
+    for (int j=0; j<lines; j++) {
+      MixData * md = &g_model.mixData[count++];
+      md->destCh = ch;
+      md->mltpx = rand() % 3;
+      md->weight = rand() % 201 - 100;
+      md->carryTrim = rand() % 2;
+      switch (rand() % 4) {
+        case 0:
+          md->srcRaw = MIXSRC_MAX;
+          break;
+        case 1:
+          md->srcRaw = (ch > 0 ? MIXSRC_CH1 + rand() % ch : MIXSRC_MAX);
+          break;
+        default:
+#if defined(VIRTUALINPUTS)
+          md->srcRaw = MIXSRC_FIRST_INPUT + rand() % NUM_STICKS;
+#else
+          md->srcRaw = MIXSRC_Rud + rand() % NUM_STICKS;
+#endif
+          break;
+      }
+      if (rand() % 6 == 0)
+        md->flightModes = 1 << (rand() % 2);
+#if defined(GVARS)
+      if (rand() % 6 == 0)
+        md->weight = GV1_LARGE + rand() % 3;
+      if (rand() % 6 == 0)
+        md->offset = GV1_LARGE + rand() % 3;
+#endif
+    }
+  }
+  for (int i=0; i<NUM_STICKS; i++) {
+    anaInValues[i] = rand() % 2048 - 1024;
+  }
+  mixerPlanUpdate();
+}
+
+// a sequence of flight mode changes, including one during a fade
+void fadeSequence(int32_t outputs[][NUM_CHNOUT], int cycles)
+{
+  for (int cycle=0; cycle<cycles; cycle++) {
+    if (cycle == 50 || cycle == 70 || cycle == 120)
+      simuSetSwitch(0, (cycle == 70) ? -1 : 1);
+    else if (cycle == 0 || cycle == 160)
+      simuSetSwitch(0, -1);
+    evalMixes(1);
+    for (int ch=0; ch<NUM_CHNOUT; ch++)
+      outputs[cycle][ch] = channelOutputs[ch];
+  }
+}
+
+TEST(Mixer, FadeSameOutputsAsPerFlightModeLoop)
+{
+  static int32_t incremental[250][NUM_CHNOUT];
+  static int32_t full[250][NUM_CHNOUT];
+  int partialModels = 0;
+  // the fades weights left by the previous tests
+  srand(0);
+  fadeRandomModel();
+  fadeSequence(full, 250);
+  for (int model=0; model<100; model++) {
+    srand(model);
+    fadeRandomModel();
+    if (mixerPlan.state == MIXER_PLAN_ORDERED && mixerPlan.fadeChannels != (bitfield_channels_t)-1)
+      partialModels++;
+    fadeSequence(incremental, 250);
+    // the original loop, which evaluates all the channels of each flight mode in turn
+    srand(model);
+    fadeRandomModel();
+    mixerPlan.fadeChannels = (bitfield_channels_t)-1;
+    fadeSequence(full, 250);
+    for (int cycle=0; cycle<250; cycle++) {
+      for (int ch=0; ch<NUM_CHNOUT; ch++) {
+        EXPECT_EQ(full[cycle][ch], incremental[cycle][ch]);
+      }
+    }
+  }
+  EXPECT_GT(partialModels, 0);
+}
+
+// The inactive flight modes are evaluated after the active one, they see the slows already moved in this cycle
+// where the original loop gives the previous values to the flight modes before the active one
+TEST(Mixer, FadeSlowsMovedBeforeInactiveFlightModes)
+{
+  static int32_t outputs[2][400];
+  for (int run=0; run<2; run++) {
+    MODEL_RESET();
+    MIXER_RESET();
+    lastFlightMode = 255;
+    g_model.flightModeData[1].swtch = TR(SWSRC_THR, SWSRC_SA0);
+    g_model.flightModeData[1].fadeIn = 10;
+    g_model.flightModeData[1].fadeOut = 10;
+    for (int i=0; i<NUM_STICKS; i++) {
+      ExpoData * ed = expoAddress(i);
+      ed->mode = 3;
+      ed->chn = i;
+      ed->weight = 100;
+#if defined(VIRTUALINPUTS)
+      ed->srcRaw = MIXSRC_Rud + i;
+#endif
+    }
+    g_model.mixData[0].destCh = 0;
+    g_model.mixData[0].srcRaw = MIXSRC_Rud;
+    g_model.mixData[0].weight = 100;
+    g_model.mixData[0].carryTrim = 1;
+    g_model.mixData[0].speedUp = 10;
+    g_model.mixData[0].speedDown = 10;
+    g_model.mixData[1].destCh = 1;
+    g_model.mixData[1].srcRaw = MIXSRC_MAX;
+    g_model.mixData[1].weight = 50;
+    mixerPlanUpdate();
+    ASSERT_EQ((bitfield_channels_t)1, mixerPlan.fadeChannels);
+    // the original loop when all the channels are evaluated for each flight mode
+    if (run == 1)
+      mixerPlan.fadeChannels = (bitfield_channels_t)-1;
+    anaInValues[0] = -1024;
+    simuSetSwitch(0, -1);
+    for (int cycle=0; cycle<400; cycle++) {
+      if (cycle == 50 || cycle == 200) {
+        // the slow moves while the flight modes fade, in both directions
+        anaInValues[0] = (cycle == 50 ? 1024 : -1024);
+        simuSetSwitch(0, cycle == 50 ? 1 : -1);
+      }
+      evalMixes(1);
+      s_mixer_first_run_done = true;
+      outputs[run][cycle] = channelOutputs[0];
+    }
+  }
+  int32_t step = 2 * RESX / (100/SLOW_STEP * 10) + 1;
+  int differences = 0;
+  for (int cycle=0; cycle<400; cycle++) {
+    if (outputs[0][cycle] != outputs[1][cycle])
+      differences++;
+    EXPECT_LE(abs(outputs[0][cycle] - outputs[1][cycle]), step);
+  }
+  EXPECT_GT(differences, 0);
+  EXPECT_EQ(outputs[0][399], outputs[1][399]);
+}
+
+#if defined(HELI)
+extern int16_t cyc_anas[3];
+#endif
+
+TEST(Mixer, SourcesResolver)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  EXPECT_EQ(getValue(MIXSRC_NONE), 0);
+#if defined(VIRTUALINPUTS)
+  for (int i=0; i<MAX_INPUTS; i++) {
+    anas[i] = 3*i - 50;
+    EXPECT_EQ(getValue(MIXSRC_FIRST_INPUT+i), 3*i - 50);
+  }
+#endif
+  for (int i=0; i<=MIXSRC_LAST_POT-MIXSRC_FIRST_STICK; i++) {
+    calibratedStick[i] = 100 - 7*i;
+    EXPECT_EQ(getValue(MIXSRC_FIRST_STICK+i), 100 - 7*i);
+  }
+  EXPECT_EQ(getValue(MIXSRC_MAX), 1024);
+#if defined(HELI)
+  cyc_anas[2] = -333;
+  EXPECT_EQ(getValue(MIXSRC_CYC3), -333);
+#endif
+  setTrimValue(0, 1, 10);
+  EXPECT_EQ(getValue(MIXSRC_TrimEle), calc1000toRESX(80));
+  g_ppmIns[NUM_TRAINER-1] = 123;
+  EXPECT_EQ(getValue(MIXSRC_LAST_TRAINER), 246);
+  for (int i=0; i<NUM_CHNOUT; i++) {
+    ex_chans[i] = 11*i;
+    EXPECT_EQ(getValue(MIXSRC_FIRST_CH+i), 11*i);
+  }
+  g_vbat100mV = 78;
+  EXPECT_EQ(getValue(MIXSRC_TX_VOLTAGE), 78);
+  timersStates[MAX_TIMERS-1].val = 42;
+  EXPECT_EQ(getValue(MIXSRC_LAST_TIMER), 42);
+  telemetryItems[MAX_SENSORS-1].value = 5;
+  telemetryItems[MAX_SENSORS-1].valueMin = -6;
+  telemetryItems[MAX_SENSORS-1].valueMax = 7;
+  EXPECT_EQ(getValue(MIXSRC_LAST_TELEM-2), 5);
+  EXPECT_EQ(getValue(MIXSRC_LAST_TELEM-1), -6);
+  EXPECT_EQ(getValue(MIXSRC_LAST_TELEM), 7);
+  EXPECT_EQ(getValue(MIXSRC_LAST_TELEM+1), 0);
+  telemetryItems[MAX_SENSORS-1].clear();
+  timersStates[MAX_TIMERS-1].val = 0;
+}
+
+TEST(Mixer, SourcesSnapshot)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  for (int i=0; i<300; i++) {
+    ex_chans[0] = i;
+    sourcesSnapshotStart();
+    EXPECT_EQ(getValue(MIXSRC_CH1), i);
+    ex_chans[0] = i + 1;
+    EXPECT_EQ(getValue(MIXSRC_CH1), i);
+    sourcesSnapshotStop();
+    EXPECT_EQ(getValue(MIXSRC_CH1), i + 1);
+  }
+#if defined(HELI)
+  sourcesSnapshotStart();
+  cyc_anas[0] = 10;
+  EXPECT_EQ(getValue(MIXSRC_CYC1), 10);
+  cyc_anas[0] = 20;
+  EXPECT_EQ(getValue(MIXSRC_CYC1), 20);
+  sourcesSnapshotStop();
+#endif
+  ex_chans[0] = 0;
+}
+
+TEST(Mixer, PulsesLatency)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  pulsesLatency.reset();
+  pulsesLatency.add(100);
+  pulsesLatency.add(300);
+  pulsesLatency.add(200);
+  EXPECT_EQ(pulsesLatency.min, 100);
+  EXPECT_EQ(pulsesLatency.max, 300);
+  EXPECT_EQ(pulsesLatency.avg(), 200);
+  LatencyStatistics latency = pulsesLatency.snapshot();
+  EXPECT_EQ(latency.count, 3u);
+  EXPECT_EQ(latency.avg(), 200);
+
+  // a frame built after the mixer is accounted with the sampling time of its channels
+  pulsesLatency.reset();
+  g_model.moduleData[EXTERNAL_MODULE].type = MODULE_TYPE_PPM;
+  doMixerCalculations();
+  setupPulses(EXTERNAL_MODULE);
+  EXPECT_EQ(pulsesLatency.count, 1u);
+  EXPECT_EQ(pulsesLatency.min, pulsesLatency.max);
+  EXPECT_LT(pulsesLatency.max, 2000*100); // less than 100ms
+}
+
+TEST(Mixer, SchedulerDelay)
+{
+  uint16_t lead = MIXER_LEAD_TIME * 2000;
+  // no wait when the frames are shorter than the lead time
+  EXPECT_EQ(getMixerSchedulerDelay(0), 0);
+  EXPECT_EQ(getMixerSchedulerDelay(lead), 0);
+  // less than one tick (2ms) left
+  EXPECT_EQ(getMixerSchedulerDelay(lead + 3999), 0);
+  EXPECT_EQ(getMixerSchedulerDelay(lead + 4000), 1);
+  // PXX (9ms) and PPM (22.5ms) frames
+  EXPECT_EQ(getMixerSchedulerDelay(18000), (18000 - lead) / 4000);
+  EXPECT_EQ(getMixerSchedulerDelay(45000), (45000 - lead) / 4000);
+  // the mixer always ends before the next frame
+  for (uint32_t period=0; period<=65535; period+=100) {
+    EXPECT_LE(uint32_t(getMixerSchedulerDelay(period)) * 4000 + lead, max<uint32_t>(period, lead));
+  }
+}
+
+TEST(Mixer, StagesStatistics)
+{
+  MixerStageStatistics stage;
+  stage.reset();
+  stage.add(10);
+  stage.add(40);
+  stage.add(5000);
+  EXPECT_EQ(stage.count, 3u);
+  EXPECT_EQ(stage.min, 10u);
+  EXPECT_EQ(stage.max, 5000u);
+  EXPECT_EQ(stage.histogram[0], 1);
+  EXPECT_EQ(stage.histogram[2], 1);
+  EXPECT_EQ(stage.histogram[MIXER_STAGE_HISTOGRAM_BINS-1], 1);
+
+  // the histogram is halved instead of overflowing
+  stage.histogram[0] = 0xffff;
+  stage.add(1);
+  EXPECT_EQ(stage.histogram[0], 0x8000);
+  EXPECT_EQ(stage.histogram[2], 0);
+
+  // each stage run by the mixer is accounted once per cycle
+  MODEL_RESET();
+  MIXER_RESET();
+  mixerStagesReset();
+  doMixerCalculations();
+  doMixerCalculations();
+  EXPECT_EQ(mixerStages[MIXER_STAGE_ADC].count, 2u);
+  EXPECT_EQ(mixerStages[MIXER_STAGE_INPUTS].count, 2u);
+  EXPECT_EQ(mixerStages[MIXER_STAGE_MIXES].count, 2u);
+  EXPECT_EQ(mixerStages[MIXER_STAGE_LIMITS].count, 2u);
+  EXPECT_LE(mixerStages[MIXER_STAGE_LIMITS].min, mixerStages[MIXER_STAGE_LIMITS].max);
+}
+
+TEST(Mixer, LimitsCache)
+{
+  MODEL_RESET();
+  EXPECT_EQ(applyLimits(0, RESX*256), RESX);
+#if defined(PCBTARANIS)
+  g_model.limitData[0].max = -500;
+#else
+  g_model.limitData[0].max = -50;
+#endif
+  // the limits are read again only when the model changes
+  EXPECT_EQ(applyLimits(0, RESX*256), RESX);
+  limitsCacheInvalidate();
+  EXPECT_EQ(applyLimits(0, RESX*256), RESX/2);
+  EXPECT_EQ(applyLimits(0, -RESX*256), -RESX);
+}
+
+#if defined(PCBTARANIS)
+TEST(Mixer, LimitsCurvePrecision)
+{
+  MODEL_RESET();
+  for (int8_t i=-2; i<=2; i++) {
+    g_model.points[2+i] = 50*i;
+  }
+  g_model.limitData[0].max = 500; // 150%, the output is more precise than the mixer resolution
+  int16_t outputs[RESX*2/7+1];
+  for (int i=0; i<=RESX*2/7; i++) {
+    outputs[i] = applyLimits(0, (i*7-RESX)*256 + 131);
+  }
+  // a linear curve doesn't change the output
+  g_model.limitData[0].curve = 1;
+  limitsCacheInvalidate();
+  for (int i=0; i<=RESX*2/7; i++) {
+    EXPECT_EQ(applyLimits(0, (i*7-RESX)*256 + 131), outputs[i]);
+  }
+  g_model.limitData[0].curve = -1;
+  limitsCacheInvalidate();
+  for (int i=0; i<=RESX*2/7; i++) {
+    EXPECT_EQ(applyLimits(0, -((i*7-RESX)*256 + 131)), outputs[i]);
+  }
+}
+#endif
+#endif
+
 #if !defined(CPUARM)
 TEST(Mixer, SlowOnSwitch)
 {
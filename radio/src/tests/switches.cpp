@@ -351,3 +351,90 @@ TEST(getSwitch, inputWithTrim)
   EXPECT_EQ(getSwitch(SWSRC_SW1), true);
 }
 #endif
+
+#if defined(CPUARM)
+void setLogicalSwitch(uint8_t idx, uint8_t func, int16_t v1, int16_t v2, int8_t andsw=0, uint8_t delay=0, uint8_t duration=0)
+{
+  LogicalSwitchData * ls = lswAddress(idx);
+  ls->func = func;
+  ls->v1 = v1;
+  ls->v2 = v2;
+  ls->andsw = andsw;
+  ls->delay = delay;
+  ls->duration = duration;
+}
+
+void runLogicalSwitchesSequence(uint8_t * states, int count, bool incremental)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  setLogicalSwitch(0, LS_FUNC_VPOS, MIXSRC_Rud, 0);
+  setLogicalSwitch(1, LS_FUNC_AND, SWSRC_SW1, SWSRC_FIRST_SWITCH);
+  setLogicalSwitch(2, LS_FUNC_OR, SWSRC_SW1+3, -SWSRC_SW1);           // reads L4 from the previous cycle
+  setLogicalSwitch(3, LS_FUNC_GREATER, MIXSRC_Rud, MIXSRC_Ele, 0, 3);
+  setLogicalSwitch(4, LS_FUNC_APOS, MIXSRC_Ele, 50, SWSRC_SW1+1, 0, 2);
+  setLogicalSwitch(5, LS_FUNC_DIFFEGREATER, MIXSRC_Rud, 10);
+  setLogicalSwitch(6, LS_FUNC_VNEG, MIXSRC_Ele, -20, -(SWSRC_SW1+2));
+
+  for (int i=0; i<count; i++) {
+    calibratedStick[RUD_STICK] = (i % 40 < 20 ? i % 20 : 20 - i % 20) * 100 - 1000;
+    calibratedStick[ELE_STICK] = (i % 30 < 15 ? 1 : -1) * (i % 7) * 50;
+    simuSetSwitch(0, (i / 25) % 2 ? 1 : -1);
+    if (i % 50 == 49) {
+      uint8_t fm = (i / 50) % 2;
+      logicalSwitchesCopyState(mixerCurrentFlightMode, fm);
+      mixerCurrentFlightMode = fm;
+    }
+    if (i % 5 == 0) {
+      logicalSwitchesTimerTick();
+    }
+    if (!incremental) {
+      logicalSwitchesGraphInvalidate();
+    }
+    evalLogicalSwitches();
+    states[i] = 0;
+    for (int ls=0; ls<7; ls++) {
+      if (getSwitch(SWSRC_SW1+ls))
+        states[i] |= (1 << ls);
+    }
+  }
+
+  simuSetSwitch(0, 0);
+}
+
+TEST(evalLogicalSwitches, incrementalMatchesFull)
+{
+  uint8_t full[400], incremental[400];
+  runLogicalSwitchesSequence(full, 400, false);
+  runLogicalSwitchesSequence(incremental, 400, true);
+  for (int i=0; i<400; i++) {
+    EXPECT_EQ(full[i], incremental[i]) << "cycle " << i;
+  }
+}
+
+TEST(evalLogicalSwitches, unchangedInputs)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  setLogicalSwitch(0, LS_FUNC_VPOS, MIXSRC_Rud, 0);
+  calibratedStick[RUD_STICK] = 100;
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1), true);
+
+  // the switch is not evaluated again until its input changes
+  g_model.logicalSw[0].v2 = 50;
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1), true);
+  calibratedStick[RUD_STICK] = 99;
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1), false);
+
+  // and the model changes are taken into account once the graph is invalidated
+  g_model.logicalSw[0].v2 = 0;
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1), false);
+  logicalSwitchesGraphInvalidate();
+  evalLogicalSwitches();
+  EXPECT_EQ(getSwitch(SWSRC_SW1), true);
+}
+#endif
@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+
+# This program converts the binary logs (LOGS_FORMAT=BINARY) to the CSV logs layout
+# usage: logs2csv.py LOGFILE [CSVFILE]
+
+import sys
+import struct
+import datetime
+
+LOGS_MAGIC = b"OTXL"
+LOGS_VERSION = 1
+LOGS_RECORD_KEYFRAME = ord('K')
+LOGS_RECORD_DELTA = ord('D')
+LOGS_FIELD_VALUE = 0
+LOGS_FIELD_SWITCHES = 1
+
+# magic, version, fieldsCount, period, tmr10ms, rtc, year, month, day, hour, min, sec, ms10
+LOGS_HEADER = struct.Struct("<4sBBHIBHBBBBBB")
+
+
+class Field:
+  def __init__(self, type, prec, label):
+    self.type = type
+    self.prec = prec
+    self.label = label
+
+  def format(self, value):
+    if self.type == LOGS_FIELD_SWITCHES:
+      count = len(self.label.split(","))
+      return ",".join("%d" % (((value >> (2*i)) & 3) - 1) for i in range(count))
+    sign = "-" if value < 0 else ""
+    if self.prec == 2:
+      return "%s%d.%02d" % (sign, abs(value) // 100, abs(value) % 100)
+    elif self.prec == 1:
+      return "%s%d.%d" % (sign, abs(value) // 10, abs(value) % 10)
+    else:
+      return "%d" % value
+
+
+class Session:
+  def __init__(self, data, offset):
+    header = LOGS_HEADER.unpack_from(data, offset)
+    if header[1] != LOGS_VERSION:
+      raise ValueError("unknown logs version %d at offset %d" % (header[1], offset))
+    self.count, self.period, self.tmr10ms, self.rtc = header[2:6]
+    if self.rtc:
+      self.date = datetime.datetime(*header[6:12]) + datetime.timedelta(milliseconds=10*header[12])
+    offset += LOGS_HEADER.size
+    self.fields = []
+    for i in range(self.count):
+      type, prec = struct.unpack_from("<BB", data, offset)
+      end = data.index(b"\0", offset+2)
+      self.fields.append(Field(type, prec, data[offset+2:end].decode("ascii")))
+      offset = end + 1
+    self.end = offset
+
+  def columns(self):
+    result = "Date,Time," if self.rtc else "Time,"
+    return result + ",".join(field.label for field in self.fields)
+
+  def row(self, tmr10ms, values):
+    if self.rtc:
+      # the same time as the CSV logs, the date and time of the header plus the time elapsed
+      time = self.date + datetime.timedelta(milliseconds=10*((tmr10ms - self.tmr10ms) & 0xFFFFFFFF))
+      result = "%4d-%02d-%02d,%02d:%02d:%02d.%02d0," % (time.year, time.month, time.day, time.hour, time.minute, time.second, time.microsecond // 10000)
+    else:
+      result = "%d," % tmr10ms
+    return result + ",".join(field.format(value) for field, value in zip(self.fields, values))
+
+
+def convert(data, output):
+  offset = 0
+  session = None
+  columns = None
+  tmr10ms = 0
+  values = []
+  while offset < len(data):
+    if data[offset:offset+4] == LOGS_MAGIC:
+      session = Session(data, offset)
+      offset = session.end
+      if session.columns() != columns:
+        columns = session.columns()
+        output.write(columns + "\n")
+      continue
+    if session is None:
+      raise ValueError("no logs header at offset %d" % offset)
+    tag, = struct.unpack_from("<B", data, offset)
+    if tag == LOGS_RECORD_KEYFRAME:
+      size = 5 + 4*session.count
+      if offset + size > len(data):
+        break
+      tmr10ms, = struct.unpack_from("<I", data, offset+1)
+      values = list(struct.unpack_from("<%di" % session.count, data, offset+5))
+    elif tag == LOGS_RECORD_DELTA:
+      size = 2 + 2*session.count
+      if offset + size > len(data):
+        break
+      elapsed, = struct.unpack_from("<B", data, offset+1)
+      tmr10ms += elapsed
+      deltas = struct.unpack_from("<%dh" % session.count, data, offset+2)
+      values = [value + delta for value, delta in zip(values, deltas)]
+    else:
+      raise ValueError("unknown record 0x%02x at offset %d" % (tag, offset))
+    output.write(session.row(tmr10ms, values) + "\n")
+    offset += size
+
+
+def main():
+  if len(sys.argv) < 2:
+    sys.stderr.write("usage: %s LOGFILE [CSVFILE]\n" % sys.argv[0])
+    sys.exit(1)
+  data = open(sys.argv[1], "rb").read()
+  output = open(sys.argv[2], "w") if len(sys.argv) > 2 else sys.stdout
+  convert(data, output)
+
+
+if __name__ == "__main__":
+  main()